@@ -0,0 +1,219 @@
+#pragma once
+
+// Standard C++ headers
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+
+namespace taz
+{
+	enum class overflow_policy : uint8_t
+	{
+		block,            // Wait for the consumer to free a slot.
+		drop_newest,      // Reject the item being pushed.
+		drop_oldest,      // Discard the oldest queued item to make room.
+		spin_then_block,  // Retry for a short while before waiting.
+	};
+
+	// Fixed-capacity ring buffer (Vyukov's bounded MPMC queue). All slots are allocated up front, so memory stays
+	// constant no matter how far the consumer falls behind; what happens to a push into a full queue is decided
+	// by Policy, and every dropped item is counted. A blocking policy must not be used for pushes made from the
+	// consumer thread itself.
+	template <std::move_constructible T, std::size_t Capacity, overflow_policy Policy = overflow_policy::block>
+	struct bounded_queue final
+	{
+		static_assert(Capacity >= 2 && std::has_single_bit(Capacity), "Capacity must be a power of two");
+
+		inline static constexpr std::size_t c_capacity = Capacity;
+		inline static constexpr overflow_policy c_policy = Policy;
+		inline static constexpr uint32_t c_spinCount = 1024;
+
+		bounded_queue()
+			: m_cells(std::make_unique<cell[]>(Capacity))
+		{
+			for (std::size_t index = 0; index < Capacity; ++index)
+			{
+				m_cells[index].m_sequence.store(index, std::memory_order_relaxed);
+			}
+		}
+		~bounded_queue()
+		{
+			while (try_pop())
+			{
+			}
+		}
+
+		bounded_queue(bounded_queue const&) = delete;
+		bounded_queue(bounded_queue&&) = delete;
+		bounded_queue& operator=(bounded_queue const&) = delete;
+		bounded_queue& operator=(bounded_queue&&) = delete;
+
+		// Returns false when the item was dropped under overflow_policy::drop_newest.
+		bool push(T&& item)
+		{
+			std::size_t evicted{};
+			return push(std::move(item), evicted);
+		}
+
+		// As above, and adds to evicted how many queued items overflow_policy::drop_oldest discarded to make room,
+		// so that a caller tracking depth can account for items that will never be popped.
+		bool push(T&& item, std::size_t& evicted)
+		{
+			if (try_push(item))
+				return true;
+
+			if constexpr (Policy == overflow_policy::drop_newest)
+			{
+				m_droppedNewest.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else if constexpr (Policy == overflow_policy::drop_oldest)
+			{
+				do
+				{
+					if (try_pop())
+					{
+						m_droppedOldest.fetch_add(1, std::memory_order_relaxed);
+						++evicted;
+					}
+				} while (!try_push(item));
+				return true;
+			}
+			else
+			{
+				if constexpr (Policy == overflow_policy::spin_then_block)
+				{
+					for (uint32_t spin = 0; spin < c_spinCount; ++spin)
+					{
+						if (try_push(item))
+							return true;
+					}
+				}
+
+				m_blocked.fetch_add(1, std::memory_order_relaxed);
+				for (;;)
+				{
+					auto observed = m_popCount.load(std::memory_order_seq_cst);
+					if (try_push(item))
+						return true;
+
+					m_waiters.fetch_add(1, std::memory_order_seq_cst);
+					if (try_push(item))
+					{
+						m_waiters.fetch_sub(1, std::memory_order_relaxed);
+						return true;
+					}
+					m_popCount.wait(observed, std::memory_order_seq_cst);
+					m_waiters.fetch_sub(1, std::memory_order_relaxed);
+				}
+			}
+		}
+
+		std::optional<T> try_pop()
+		{
+			auto position = m_dequeuePosition.load(std::memory_order_relaxed);
+			cell* target{};
+			for (;;)
+			{
+				target = &m_cells[position & c_mask];
+				auto sequence = target->m_sequence.load(std::memory_order_acquire);
+				auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+				if (difference == 0)
+				{
+					if (m_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (difference < 0)
+				{
+					return std::nullopt;
+				}
+				else
+				{
+					position = m_dequeuePosition.load(std::memory_order_relaxed);
+				}
+			}
+
+			auto value = std::launder(reinterpret_cast<T*>(target->m_storage));
+			std::optional<T> result{ std::move(*value) };
+			value->~T();
+			target->m_sequence.store(position + Capacity, std::memory_order_release);
+
+			if constexpr (Policy == overflow_policy::block || Policy == overflow_policy::spin_then_block)
+			{
+				m_popCount.fetch_add(1, std::memory_order_seq_cst);
+				if (m_waiters.load(std::memory_order_seq_cst) != 0)
+					m_popCount.notify_all();
+			}
+
+			return result;
+		}
+
+		std::size_t dropped_newest() const { return m_droppedNewest.load(std::memory_order_relaxed); }
+		std::size_t dropped_oldest() const { return m_droppedOldest.load(std::memory_order_relaxed); }
+		std::size_t dropped() const { return dropped_newest() + dropped_oldest(); }
+		std::size_t blocked_pushes() const { return m_blocked.load(std::memory_order_relaxed); }
+
+	private:
+		inline static constexpr std::size_t c_mask = Capacity - 1;
+
+		struct cell final
+		{
+			std::atomic<std::size_t> m_sequence{};
+			alignas(T) std::byte m_storage[sizeof(T)];
+		};
+
+		// Moves from item only when a slot was claimed.
+		bool try_push(T& item)
+		{
+			auto position = m_enqueuePosition.load(std::memory_order_relaxed);
+			cell* target{};
+			for (;;)
+			{
+				target = &m_cells[position & c_mask];
+				auto sequence = target->m_sequence.load(std::memory_order_acquire);
+				auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+				if (difference == 0)
+				{
+					if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (difference < 0)
+				{
+					return false;
+				}
+				else
+				{
+					position = m_enqueuePosition.load(std::memory_order_relaxed);
+				}
+			}
+
+			::new (static_cast<void*>(target->m_storage)) T(std::move(item));
+			target->m_sequence.store(position + 1, std::memory_order_release);
+			return true;
+		}
+
+		std::unique_ptr<cell[]> m_cells;
+		alignas(64) std::atomic<std::size_t> m_enqueuePosition{};
+		alignas(64) std::atomic<std::size_t> m_dequeuePosition{};
+		alignas(64) std::atomic<uint32_t> m_popCount{};
+		std::atomic<uint32_t> m_waiters{};
+		std::atomic<std::size_t> m_droppedNewest{};
+		std::atomic<std::size_t> m_droppedOldest{};
+		std::atomic<std::size_t> m_blocked{};
+	};
+
+	// Adapts bounded_queue to thread_queue's backend parameter, e.g.
+	// thread_queue<item, bounded<4096, overflow_policy::drop_oldest>::queue>.
+	template <std::size_t Capacity, overflow_policy Policy = overflow_policy::block>
+	struct bounded final
+	{
+		template <typename T>
+		using queue = bounded_queue<T, Capacity, Policy>;
+	};
+}
@@ -1,35 +1,246 @@
 #pragma once
 
 // Standard C headers
+#include <errno.h>
 #include <stdio.h>
 
 // Standard C++ headers
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <variant>
+#include <vector>
+
+#if defined(_WIN32)
+// Windows headers
+#include <io.h>
+#include <consoleapi.h>
+#include <fileapi.h>
+#else
+#include <unistd.h>
+#endif
 
 // Local headers
 #include "formatters.h"
+#include "inplace_task.h"
 #include "logger.h"
+#include "spill_writer.h"
 #include "string_utility.h"
 #include "thread_queue.h"
 
 namespace taz
 {
+	namespace details
+	{
+		// A Windows console only displays UTF-16 reliably, so text for one is written with WriteConsoleW. Asking
+		// costs a system call, so streams ask once and pass the answer along.
+		inline bool is_console([[maybe_unused]] FILE* file)
+		{
+#if defined(_WIN32)
+			DWORD mode{};
+			return GetConsoleMode(reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file))), &mode) != FALSE;
+#else
+			return false;
+#endif
+		}
+
+#if defined(_WIN32)
+		inline void write_console(FILE* file, std::wstring_view text)
+		{
+			auto handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+			while (!text.empty())
+			{
+				DWORD written{};
+				auto chunk = static_cast<DWORD>(std::min<std::size_t>(text.size(), 1u << 30));
+				if (!WriteConsoleW(handle, text.data(), chunk, &written, nullptr))
+					return;
+				text.remove_prefix(written);
+			}
+		}
+#endif
+
+		// Writes UTF-8 straight to the stream's file descriptor, bypassing the C runtime's buffer and its locale
+		// conversion; for a console it is widened, in chunks on the stack. Output that fails to write is dropped,
+		// as fputws would.
+		inline void write_utf8(FILE* file, std::string_view text, [[maybe_unused]] bool console)
+		{
+#if defined(_WIN32)
+			if (console)
+			{
+				string_utility::inplace_wstring<1024> buffer;
+				for (; !text.empty(); buffer.clear())
+				{
+					auto result = string_utility::widen_append(text, buffer);
+					text.remove_prefix(result.m_read);
+					write_console(file, buffer.view());
+				}
+				return;
+			}
+
+			auto handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+			if (handle == INVALID_HANDLE_VALUE)
+				return;
+
+			while (!text.empty())
+			{
+				DWORD written{};
+				auto chunk = static_cast<DWORD>(std::min<std::size_t>(text.size(), 1u << 30));
+				if (!WriteFile(handle, text.data(), chunk, &written, nullptr))
+					return;
+				text.remove_prefix(written);
+			}
+#else
+			auto descriptor = fileno(file);
+			while (!text.empty())
+			{
+				auto written = ::write(descriptor, text.data(), text.size());
+				if (written < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					return;
+				}
+				text.remove_prefix(static_cast<std::size_t>(written));
+			}
+#endif
+		}
+
+		// Writes UTF-16 to a console as it is, and converted to UTF-8 anywhere else.
+		inline void write_wide(FILE* file, std::wstring_view text, [[maybe_unused]] bool console)
+		{
+#if defined(_WIN32)
+			if (console)
+			{
+				write_console(file, text);
+				return;
+			}
+#endif
+			string_utility::inplace_string<1024> buffer;
+			for (; !text.empty(); buffer.clear())
+			{
+				auto result = string_utility::narrow_append(text, buffer);
+				write_utf8(file, buffer.view(), false);
+				text.remove_prefix(result.m_read);
+			}
+		}
+
+		// For one-off writes, such as reports on stderr, where caching the console check isn't worth it.
+		inline void write_utf8(FILE* file, std::string_view text)
+		{
+			write_utf8(file, text, is_console(file));
+		}
+	}
+
+	// Coalescing keeps console output on the console thread while more is queued behind it, until m_flushBytes
+	// have built up or the oldest byte has waited m_maxLatency, so a busy logger issues one write per buffer
+	// instead of one per batch. When the queue runs empty, output is held for m_idleWait more in case the
+	// producer is only a little slower than the console thread, and written if nothing follows. Output is also
+	// flushed on exit, before a posted task runs and when the target stream changes. Waits are rounded up to
+	// the system timer's resolution.
+	struct console_coalescing final
+	{
+		std::size_t m_flushBytes{ 64 * 1024 };
+		std::chrono::milliseconds m_maxLatency{ 50 };
+		std::chrono::milliseconds m_idleWait{ 1 };
+	};
+
+	// Messages are queued as they are written. Wide messages for anything but a Windows console are converted
+	// to UTF-8 once, on the producer; a console takes UTF-16, so there they stay wide, and a console is only
+	// detected once per stream. Every stream has its own queue and console thread, so a flood on stdout never
+	// holds up stderr.
 	struct console_output final
 	{
 		void write_out(std::string const& message)
 		{
-			StringWorkItem workItem{ std::move(string_utility::widen(message)), m_file };
-			s_queue.push( std::move(workItem) );
+			submit(std::string{ message });
 		}
 		void write_out(std::wstring const& message)
 		{
-			StringWorkItem workItem(std::wstring{ message }, m_file);
-			s_queue.push( std::move(workItem) );
+			if (m_stream->m_console)
+			{
+				m_stream->push(StringWorkItem{ std::wstring{ message }, m_stream });
+				return;
+			}
+
+			std::string utf8Message;
+			string_utility::narrow_append(message, utf8Message);
+			submit(std::move(utf8Message));
+		}
+
+		// Called on a queue thread that has already done the formatting, so write without re-queuing.
+		void write_direct(std::string const& message)
+		{
+			details::write_utf8(m_stream->m_file, message, m_stream->m_console);
+		}
+		void write_direct(std::wstring const& message)
+		{
+			details::write_wide(m_stream->m_file, message, m_stream->m_console);
+		}
+
+		// Runs callable on this stream's console thread, ordered with the messages written before and after it.
+		// Captures must fit in task_type, so this never allocates.
+		template <std::invocable F>
+		void post(F&& callable)
+		{
+			m_stream->push(StringWorkItem{ task_type{ std::forward<F>(callable) }, m_stream });
+		}
+
+		// Switches every console_output to coalescing, or back to one write per batch with std::nullopt. The
+		// change is queued, so it applies to messages written after this call.
+		static void coalesce(std::optional<console_coalescing> policy)
+		{
+			auto& registry = streams();
+			std::lock_guard lock{ registry.m_lock };
+			registry.m_policy = policy;
+			for (auto& stream : registry.m_streams)
+			{
+				stream->m_policy = policy;
+				if (stream->m_queue.started())
+					stream->post(task_type{ [policy] { StringWorkItem::set_policy(policy); } });
+			}
+		}
+
+		// With spilling on, pipes and sockets are written without blocking; whatever a slow reader is not ready
+		// for goes to a temporary file and is replayed as it drains, so producers never wait on the reader. At
+		// exit, or when spilling is turned off, the reader gets a short while to take what is left; whatever it
+		// doesn't is left in the file and its path written to stderr. If the file can't be written, the console
+		// thread waits for the reader instead, as it would have without spilling. Queued, like coalesce.
+		static void spill_on_stall(bool enabled)
+		{
+			auto& registry = streams();
+			std::lock_guard lock{ registry.m_lock };
+			registry.m_spilling = enabled;
+			for (auto& stream : registry.m_streams)
+			{
+				stream->m_spilling = enabled;
+				if (stream->m_queue.started())
+					stream->post(task_type{ [enabled] { StringWorkItem::set_spilling(enabled); } });
+			}
+		}
+
+		// With staging on, each producer thread collects its messages and posted tasks in a buffer of its own
+		// instead of pushing every one through the stream's queue; the console thread takes whole buffers and
+		// merges them by the sequence number each drew when it was written. A thread's output keeps its order,
+		// and producers only meet on an atomic counter and, once per collection, the queue.
+		static void stage_per_thread(bool enabled)
+		{
+			s_staging.store(enabled, std::memory_order_relaxed);
 		}
 
 		console_output(FILE* file)
-			: m_file(file)
+			: m_stream(&stream_for(file))
 		{
 		}
 		~console_output() = default;
@@ -40,53 +251,492 @@ namespace taz
 
 		void exit()
 		{
-			s_queue.exit();
+			m_stream->m_queue.exit();
 		}
 
 	public:
+		using task_type = inplace_task<>;
+
+		struct stream;
+
+		// A message, a wide message for a console, a task posted with post(), or a request to collect staged
+		// work; all run in queue order.
 		struct StringWorkItem final
 		{
+			struct collect final
+			{
+			};
+
 			StringWorkItem() = default;
 			~StringWorkItem() = default;
-			StringWorkItem(std::wstring&& message, FILE* file)
-				: m_file(file)
+			StringWorkItem(std::string&& message, stream* target)
+				: m_payload(std::in_place_index<0>, std::move(message))
+				, m_stream(target)
 			{
-				std::swap(message, m_message);
 			}
-			StringWorkItem(const StringWorkItem& that)
-				: m_message(that.m_message)
-				, m_file(that.m_file)
+			StringWorkItem(task_type&& task, stream* target)
+				: m_payload(std::in_place_index<1>, std::move(task))
+				, m_stream(target)
 			{
 			}
-			StringWorkItem(StringWorkItem&& that) noexcept
-				: m_message(std::move(that.m_message))
+			StringWorkItem(collect, stream* target)
+				: m_payload(std::in_place_index<2>)
+				, m_stream(target)
+			{
+			}
+			StringWorkItem(std::wstring&& message, stream* target)
+				: m_payload(std::in_place_index<3>, std::move(message))
+				, m_stream(target)
 			{
-				std::swap(m_file, that.m_file);
 			}
-			StringWorkItem operator=(StringWorkItem& that)
+			StringWorkItem(StringWorkItem&& that) noexcept
+				: m_payload(std::move(that.m_payload))
 			{
-				m_message = that.m_message;
-				std::swap(m_file, that.m_file);
+				std::swap(m_stream, that.m_stream);
 			}
-			StringWorkItem operator=(StringWorkItem&& that) noexcept
+			StringWorkItem& operator=(StringWorkItem&& that) noexcept
 			{
-				m_message = std::move(that.m_message);
-				std::swap(m_file, that.m_file);
+				m_payload = std::move(that.m_payload);
+				std::swap(m_stream, that.m_stream);
+				return *this;
 			}
 
+			StringWorkItem(StringWorkItem const&) = delete;
+			StringWorkItem& operator=(StringWorkItem const&) = delete;
+
 			void execute()
 			{
-				fputws(m_message.c_str(), m_file);
+				execute_batch(std::span<StringWorkItem>{ this, 1 });
+			}
+
+			// Joins consecutive messages so that each run is written with one call. When coalescing, the joined
+			// text is held back until the policy says otherwise.
+			static void execute_batch(std::span<StringWorkItem> workItems)
+			{
+				if (!t_configured && !workItems.empty())
+				{
+					t_configured = true;
+					configure(*workItems.front().m_stream);
+				}
+
+				for (auto& workItem : workItems)
+				{
+					run(workItem);
+				}
+
+				if (!t_policy || (t_batchBuffer.empty() && t_wideBatchBuffer.empty()) || clock::now() - t_pendingSince >= t_policy->m_maxLatency)
+					flush();
+			}
+
+			// Nothing else is queued. Output that arrived since the last idle call is held for one more wait
+			// while coalescing; anything that sat through a wait, or has reached the latency limit, is written.
+			static std::chrono::milliseconds on_idle(bool exiting)
+			{
+				auto wait = std::chrono::milliseconds::max();
+				auto hold = std::exchange(t_appended, false) && t_policy && !exiting;
+				if (hold)
+				{
+					auto remaining = std::chrono::ceil<std::chrono::milliseconds>(t_pendingSince + t_policy->m_maxLatency - clock::now());
+					hold = remaining.count() > 0;
+					wait = std::min(t_policy->m_idleWait, remaining);
+				}
+				if (!hold)
+				{
+					flush();
+					wait = std::chrono::milliseconds::max();
+				}
+
+				if (exiting)
+				{
+					release_spill_writers();
+					return wait;
+				}
+
+				for (auto& [file, writer] : t_spillWriters)
+				{
+					if (writer && !writer->drain())
+						wait = std::min(wait, c_drainInterval);
+				}
+				return wait;
+			}
+
+			static void set_policy(std::optional<console_coalescing> policy)
+			{
+				flush();
+				t_policy = policy;
+				if (t_policy)
+					t_batchBuffer.reserve(t_policy->m_flushBytes);
+			}
+
+			static void set_spilling(bool enabled)
+			{
+				flush();
+				if (!enabled)
+					release_spill_writers();
+				t_spilling = enabled;
 			}
 
 		private:
-			std::wstring m_message;
-			FILE* m_file{};
+			using clock = std::chrono::steady_clock;
+
+			// How often spilled output is retried while a reader is stalled.
+			inline static constexpr std::chrono::milliseconds c_drainInterval{ 10 };
+			// How long a stalled reader may hold up exit or turning spilling off.
+			inline static constexpr std::chrono::milliseconds c_releaseTimeout{ 500 };
+
+			// Applies the settings the stream was given before its console thread existed. Settings made after the
+			// thread started are posted to it as tasks instead, so they stay ordered with the messages.
+			static void configure(stream& target)
+			{
+				std::optional<console_coalescing> policy;
+				bool spilling{};
+				{
+					auto& registry = streams();
+					std::lock_guard lock{ registry.m_lock };
+					policy = target.m_policy;
+					spilling = target.m_spilling;
+				}
+				set_policy(policy);
+				set_spilling(spilling);
+			}
+
+			static void run(StringWorkItem& workItem)
+			{
+				if (auto message = std::get_if<0>(&workItem.m_payload))
+				{
+					append(*workItem.m_stream, t_batchBuffer, *message);
+				}
+				else if (auto wideMessage = std::get_if<3>(&workItem.m_payload))
+				{
+					append(*workItem.m_stream, t_wideBatchBuffer, *wideMessage);
+				}
+				else if (auto task = std::get_if<1>(&workItem.m_payload))
+				{
+					flush();
+					run_task(*task);
+				}
+				else
+				{
+					collect_staged(*workItem.m_stream);
+				}
+			}
+
+			// A task that throws must not cost the messages and tasks queued behind it in the same batch.
+			static void run_task(task_type& task)
+			{
+				try
+				{
+					task();
+				}
+				catch (std::exception const& ex)
+				{
+					debug.write_line(L"taz::console_output: posted task exception={}", ex.what());
+				}
+				catch (...)
+				{
+					debug.write_line(L"taz::console_output: posted task unknown exception");
+				}
+			}
+
+			// Narrow and wide text are held in separate buffers, so switching between them flushes, as does
+			// switching streams.
+			template <typename CharT>
+			static void append(stream& target, std::basic_string<CharT>& buffer, std::basic_string<CharT> const& message)
+			{
+				auto otherPending = std::same_as<CharT, char> ? !t_wideBatchBuffer.empty() : !t_batchBuffer.empty();
+				if (&target != t_pendingStream || otherPending)
+				{
+					flush();
+					t_pendingStream = &target;
+				}
+
+				if (buffer.empty())
+					t_pendingSince = clock::now();
+				buffer.append(message);
+				t_appended = true;
+
+				if (t_policy && buffer.size() * sizeof(CharT) >= t_policy->m_flushBytes)
+					flush();
+			}
+
+			// Takes every producer's staged work, merges it by sequence number and runs it. Each buffer's items are
+			// swapped out whole for an empty vector kept from an earlier collection, so a producer only ever waits
+			// for a swap, and the runs are merged through a heap of cursors without moving the items again.
+			static void collect_staged(stream& target)
+			{
+				struct cursor final
+				{
+					uint64_t m_sequence{};
+					std::size_t m_run{};
+					std::size_t m_index{};
+				};
+				thread_local std::vector<std::vector<staged_work_item>> t_runs;
+				thread_local std::vector<std::vector<staged_work_item>> t_spareRuns;
+				thread_local std::vector<cursor> t_cursors;
+
+				auto runs = std::exchange(t_runs, {});
+				{
+					std::lock_guard lock{ target.m_stagingLock };
+					std::erase_if(target.m_stagingBuffers, [&](std::shared_ptr<staging_buffer> const& buffer)
+					{
+						std::vector<staged_work_item> staged;
+						if (!t_spareRuns.empty())
+						{
+							staged = std::move(t_spareRuns.back());
+							t_spareRuns.pop_back();
+						}
+
+						bool retired{};
+						{
+							std::lock_guard bufferLock{ buffer->m_lock };
+							std::swap(staged, buffer->m_workItems);
+							retired = buffer->m_retired;
+						}
+
+						if (staged.empty())
+							t_spareRuns.push_back(std::move(staged));
+						else
+							runs.push_back(std::move(staged));
+						return retired;
+					});
+				}
+
+				auto cursors = std::exchange(t_cursors, {});
+				auto later = [](cursor const& left, cursor const& right) { return left.m_sequence > right.m_sequence; };
+				for (std::size_t index = 0; index < runs.size(); ++index)
+					cursors.push_back({ runs[index].front().m_sequence, index, 0 });
+				std::make_heap(cursors.begin(), cursors.end(), later);
+
+				while (!cursors.empty())
+				{
+					std::pop_heap(cursors.begin(), cursors.end(), later);
+					auto& next = cursors.back();
+					auto& items = runs[next.m_run];
+					run(items[next.m_index].m_workItem);
+					if (++next.m_index < items.size())
+					{
+						next.m_sequence = items[next.m_index].m_sequence;
+						std::push_heap(cursors.begin(), cursors.end(), later);
+					}
+					else
+					{
+						cursors.pop_back();
+					}
+				}
+
+				// Hand the capacity back for the next collection.
+				for (auto& staged : runs)
+				{
+					staged.clear();
+					t_spareRuns.push_back(std::move(staged));
+				}
+				runs.clear();
+				t_runs = std::move(runs);
+				t_cursors = std::move(cursors);
+			}
+
+			static void write(stream& target, std::string_view text)
+			{
+				if (auto writer = spill_writer_for(target.m_file))
+					writer->write(text);
+				else
+					details::write_utf8(target.m_file, text, target.m_console);
+			}
+
+			static void flush()
+			{
+				if (t_pendingStream && !t_batchBuffer.empty())
+					write(*t_pendingStream, t_batchBuffer);
+				if (t_pendingStream && !t_wideBatchBuffer.empty())
+					details::write_wide(t_pendingStream->m_file, t_wideBatchBuffer, t_pendingStream->m_console);
+				t_batchBuffer.clear();
+				t_wideBatchBuffer.clear();
+				t_appended = false;
+			}
+
+			static spill_writer* spill_writer_for(FILE* file)
+			{
+				if (!t_spilling)
+					return nullptr;
+
+				auto found = std::find_if(t_spillWriters.begin(), t_spillWriters.end(), [&](auto const& entry) { return entry.first == file; });
+				if (found == t_spillWriters.end())
+				{
+					// Streams that can't stall are remembered with no writer, so they are only checked once.
+					auto& entry = t_spillWriters.emplace_back(file, spill_writer::create(file));
+					return entry.second.get();
+				}
+				return found->second.get();
+			}
+
+			// Sends what the reader takes within c_releaseTimeout and reports where the rest was left. stderr is
+			// written directly, so the report is seen in release builds too.
+			static void release_spill_writers()
+			{
+				for (auto& [file, writer] : t_spillWriters)
+				{
+					if (writer && !writer->finish(c_releaseTimeout))
+					{
+						auto report = "taz::console_output: output that could not be sent was left in "
+							+ string_utility::narrow(writer->spill_path().wstring()) + "\n";
+						details::write_utf8(stderr, report);
+					}
+				}
+				t_spillWriters.clear();
+			}
+
+			// Each console thread serves one stream, so its state is per thread.
+			inline static thread_local bool t_configured{};
+			inline static thread_local std::string t_batchBuffer{};
+			inline static thread_local std::wstring t_wideBatchBuffer{};
+			inline static thread_local stream* t_pendingStream{};
+			inline static thread_local clock::time_point t_pendingSince{};
+			inline static thread_local bool t_appended{};
+			inline static thread_local std::optional<console_coalescing> t_policy{};
+			inline static thread_local bool t_spilling{};
+			inline static thread_local std::vector<std::pair<FILE*, std::unique_ptr<spill_writer>>> t_spillWriters{};
+
+			std::variant<std::string, task_type, collect, std::wstring> m_payload;
+			stream* m_stream{};
+		};
+		static_assert(BatchWorkItem<StringWorkItem> && IdleWorkItem<StringWorkItem>);
+
+		struct staged_work_item final
+		{
+			uint64_t m_sequence{};
+			StringWorkItem m_workItem{};
 		};
-		static_assert(WorkItem<StringWorkItem>);
 
-		inline static thread_queue<StringWorkItem> s_queue{};
-		FILE* m_file{};
+		// One producer thread's staged work for one stream. The lock is only ever shared with the console
+		// thread when it collects.
+		struct staging_buffer final
+		{
+			std::mutex m_lock{};
+			std::vector<staged_work_item> m_workItems{};
+			bool m_retired{};
+		};
+
+		struct stream final
+		{
+			explicit stream(FILE* file)
+				: m_file(file)
+				, m_console(details::is_console(file))
+			{
+			}
+			~stream() = default;
+			stream(stream const&) = delete;
+			stream(stream&&) = delete;
+			stream& operator=(stream const&) = delete;
+			stream& operator=(stream&&) = delete;
+
+			void push(StringWorkItem&& workItem)
+			{
+				if (!s_staging.load(std::memory_order_relaxed))
+				{
+					m_queue.push(std::move(workItem));
+					return;
+				}
+
+				// Only the item that makes the buffer non-empty queues a collection; later ones ride along.
+				auto& buffer = staging_for(*this);
+				bool first{};
+				{
+					std::lock_guard lock{ buffer.m_lock };
+					first = buffer.m_workItems.empty();
+					buffer.m_workItems.push_back({ m_sequence.fetch_add(1, std::memory_order_relaxed), std::move(workItem) });
+				}
+				if (first)
+					m_queue.push(StringWorkItem{ StringWorkItem::collect{}, this });
+			}
+
+			void post(task_type&& task)
+			{
+				push(StringWorkItem{ std::move(task), this });
+			}
+
+			FILE* const m_file;
+			bool const m_console;
+			// Started by the first message, so including this header costs no thread until the stream is used.
+			thread_queue<StringWorkItem> m_queue{ thread_start::on_first_push };
+			// Guarded by the registry lock. Read by the console thread when it starts; see configure().
+			std::optional<console_coalescing> m_policy{};
+			bool m_spilling{};
+			std::atomic<uint64_t> m_sequence{};
+			std::mutex m_stagingLock{};
+			std::vector<std::shared_ptr<staging_buffer>> m_stagingBuffers{};
+		};
+
+	private:
+		struct stream_registry final
+		{
+			std::mutex m_lock{};
+			std::vector<std::unique_ptr<stream>> m_streams{};
+			std::optional<console_coalescing> m_policy{};
+			bool m_spilling{};
+		};
+
+		// Deliberately never destroyed: loggers with static storage duration, and work items still queued during
+		// static destruction, point at the streams, so they must outlive every other static.
+		static stream_registry& streams()
+		{
+			static auto& s_registry = *new stream_registry;
+			return s_registry;
+		}
+
+		static stream& stream_for(FILE* file)
+		{
+			auto& registry = streams();
+			std::lock_guard lock{ registry.m_lock };
+			auto found = std::find_if(registry.m_streams.begin(), registry.m_streams.end(), [&](auto const& stream) { return stream->m_file == file; });
+			if (found != registry.m_streams.end())
+				return **found;
+
+			auto& created = *registry.m_streams.emplace_back(std::make_unique<stream>(file));
+			created.m_policy = registry.m_policy;
+			created.m_spilling = registry.m_spilling;
+			return created;
+		}
+
+		// This thread's staging buffer for the stream, registered with the stream on first use. When the thread
+		// ends its buffers are marked retired, and the console thread drops them after collecting what is left.
+		static staging_buffer& staging_for(stream& target)
+		{
+			struct thread_buffers final
+			{
+				~thread_buffers()
+				{
+					for (auto& [owner, buffer] : m_buffers)
+					{
+						std::lock_guard lock{ buffer->m_lock };
+						buffer->m_retired = true;
+					}
+				}
+
+				std::vector<std::pair<stream*, std::shared_ptr<staging_buffer>>> m_buffers{};
+			};
+			thread_local thread_buffers buffers;
+
+			for (auto& [owner, buffer] : buffers.m_buffers)
+			{
+				if (owner == &target)
+					return *buffer;
+			}
+
+			auto buffer = std::make_shared<staging_buffer>();
+			{
+				std::lock_guard lock{ target.m_stagingLock };
+				target.m_stagingBuffers.push_back(buffer);
+			}
+			return *buffers.m_buffers.emplace_back(&target, std::move(buffer)).second;
+		}
+
+		void submit(std::string&& message)
+		{
+			m_stream->push(StringWorkItem{ std::move(message), m_stream });
+		}
+
+		inline static std::atomic<bool> s_staging{};
+		stream* m_stream{};
 	};
 	static_assert(log_writer<console_output>);
 
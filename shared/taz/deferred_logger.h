@@ -0,0 +1,476 @@
+#pragma once
+
+// Standard C++ headers
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Local headers
+#include "logger.h"
+#include "thread_queue.h"
+
+// WIL headers
+#include <wil/resource.h>
+
+namespace taz
+{
+	// Static, per-call-site description of a deferred message. Only a pointer to this is queued, so it
+	// must outlive the logger; declare it `static constexpr` at the call site or use TAZ_DEFERRED_LINE.
+	template <typename CharT>
+	struct basic_log_site final
+	{
+		constexpr basic_log_site(std::basic_string_view<CharT> format, bool newline = true)
+			: format(format)
+			, newline(newline)
+		{
+		}
+
+		template <std::size_t N>
+		constexpr basic_log_site(CharT const (&format)[N], bool newline = true)
+			: format(format, N - 1)
+			, newline(newline)
+		{
+		}
+
+		std::basic_string_view<CharT> format;
+		bool newline{ true };
+	};
+
+	template <typename CharT, std::size_t N>
+	basic_log_site(CharT const (&)[N], bool = true) -> basic_log_site<CharT>;
+
+	using log_site = basic_log_site<char>;
+	using wlog_site = basic_log_site<wchar_t>;
+
+	// A writer that can emit a fully formatted message synchronously, without queuing it again.
+	template <typename Writer>
+	concept direct_log_writer = log_writer<Writer> && requires(Writer w)
+	{
+		w.write_direct(""s);
+		w.write_direct(L""s);
+	};
+
+	namespace details
+	{
+		// Per-thread arena block. The producer bumps through it without any atomics; the reference count
+		// goes negative as the consumer releases records and the producer adds its allocation count when it
+		// retires the block, so whichever side brings the count back to zero frees it.
+		struct deferred_block final
+		{
+			inline static constexpr std::size_t c_defaultSize = 64 * 1024;
+
+			static deferred_block* create(std::size_t size)
+			{
+				auto memory = ::operator new(sizeof(deferred_block) + size);
+				return ::new (memory) deferred_block(size);
+			}
+
+			std::byte* data() { return reinterpret_cast<std::byte*>(this + 1); }
+			std::size_t size() const { return m_size; }
+
+			void release()
+			{
+				if (m_references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					destroy();
+				}
+			}
+
+			void retire(std::int64_t allocationCount)
+			{
+				if (m_references.fetch_add(allocationCount, std::memory_order_acq_rel) == -allocationCount)
+				{
+					destroy();
+				}
+			}
+
+		private:
+			explicit deferred_block(std::size_t size)
+				: m_size(size)
+			{
+			}
+
+			void destroy()
+			{
+				this->~deferred_block();
+				::operator delete(this);
+			}
+
+			std::atomic<std::int64_t> m_references{};
+			std::size_t m_size{};
+		};
+
+		struct deferred_thread_buffer final
+		{
+			~deferred_thread_buffer()
+			{
+				retire();
+			}
+
+			std::byte* allocate(std::size_t size, std::size_t alignment, deferred_block*& block)
+			{
+				auto offset = m_block ? align_up(m_offset, alignment) : 0;
+				if (!m_block || offset + size > m_block->size())
+				{
+					retire();
+					m_block = deferred_block::create(std::max(deferred_block::c_defaultSize, size + alignment));
+					offset = align_up(reinterpret_cast<std::uintptr_t>(m_block->data()), alignment) - reinterpret_cast<std::uintptr_t>(m_block->data());
+				}
+
+				m_offset = offset + size;
+				++m_allocationCount;
+				block = m_block;
+				return m_block->data() + offset;
+			}
+
+		private:
+			static std::size_t align_up(std::size_t value, std::size_t alignment)
+			{
+				return (value + alignment - 1) & ~(alignment - 1);
+			}
+
+			void retire()
+			{
+				if (m_block)
+				{
+					m_block->retire(m_allocationCount);
+					m_block = nullptr;
+					m_offset = 0;
+					m_allocationCount = 0;
+				}
+			}
+
+			deferred_block* m_block{};
+			std::size_t m_offset{};
+			std::int64_t m_allocationCount{};
+		};
+
+		inline deferred_thread_buffer& current_deferred_buffer()
+		{
+			thread_local deferred_thread_buffer buffer;
+			return buffer;
+		}
+
+		template <typename T>
+		concept deferred_character = std::same_as<T, char> || std::same_as<T, wchar_t>;
+
+		// Decides how a single argument is captured. String-like arguments are copied into the arena so that
+		// nothing on the record refers back to caller memory; everything else is captured by value.
+		template <typename T>
+		struct deferred_capture
+		{
+			using stored_type = std::decay_t<T>;
+			static std::size_t extra_size(T const&) { return 0; }
+			static stored_type capture(T const& value, std::byte*&) { return value; }
+		};
+
+		template <deferred_character C>
+		struct deferred_capture_chars
+		{
+			static std::size_t extra_size(std::basic_string_view<C> value)
+			{
+				return (value.size() + 1) * sizeof(C) + alignof(C) - 1;
+			}
+
+			static C* copy(std::basic_string_view<C> value, std::byte*& extra)
+			{
+				auto address = reinterpret_cast<std::uintptr_t>(extra);
+				auto chars = reinterpret_cast<C*>((address + alignof(C) - 1) & ~(alignof(C) - 1));
+				std::char_traits<C>::copy(chars, value.data(), value.size());
+				chars[value.size()] = C{};
+				extra = reinterpret_cast<std::byte*>(chars + value.size() + 1);
+				return chars;
+			}
+		};
+
+		template <deferred_character C>
+		struct deferred_capture<C const*> : deferred_capture_chars<C>
+		{
+			using stored_type = C const*;
+			static std::size_t extra_size(C const* value)
+			{
+				return value ? deferred_capture_chars<C>::extra_size(value) : 0;
+			}
+			static stored_type capture(C const* value, std::byte*& extra)
+			{
+				return value ? deferred_capture_chars<C>::copy(value, extra) : nullptr;
+			}
+		};
+
+		template <deferred_character C>
+		struct deferred_capture<C*> : deferred_capture<C const*>
+		{
+		};
+
+		template <deferred_character C, std::size_t N>
+		struct deferred_capture<C[N]> : deferred_capture<C const*>
+		{
+		};
+
+		template <deferred_character C, std::size_t N>
+		struct deferred_capture<C const[N]> : deferred_capture<C const*>
+		{
+		};
+
+		template <deferred_character C, typename Traits>
+		struct deferred_capture<std::basic_string_view<C, Traits>> : deferred_capture_chars<C>
+		{
+			using stored_type = std::basic_string_view<C, Traits>;
+			static stored_type capture(std::basic_string_view<C, Traits> value, std::byte*& extra)
+			{
+				return { deferred_capture_chars<C>::copy(value, extra), value.size() };
+			}
+		};
+
+		template <deferred_character C, typename Traits, typename Alloc>
+		struct deferred_capture<std::basic_string<C, Traits, Alloc>> : deferred_capture<std::basic_string_view<C, Traits>>
+		{
+		};
+
+		template <typename T>
+		using deferred_capture_t = deferred_capture<std::remove_cvref_t<T>>;
+
+		struct deferred_record
+		{
+			void (*m_invoke)(deferred_record&, void* writer){};
+			void* m_writer{};
+			deferred_block* m_block{};
+		};
+
+		template <typename CharT, log_writer Writer, typename... Stored>
+		struct deferred_record_of final : deferred_record
+		{
+			basic_log_site<CharT> const* m_site{};
+			std::tuple<Stored...> m_arguments;
+
+			static void invoke(deferred_record& record, void* writer)
+			{
+				auto& self = static_cast<deferred_record_of&>(record);
+				auto destroy = wil::scope_exit([&] { self.~deferred_record_of(); });
+
+				thread_local std::basic_string<CharT> message;
+				message.clear();
+
+				std::apply([&](auto&... arguments)
+					{
+						if constexpr (std::same_as<CharT, char>)
+						{
+							std::vformat_to(std::back_inserter(message), self.m_site->format, std::make_format_args(arguments...));
+						}
+						else
+						{
+							std::vformat_to(std::back_inserter(message), self.m_site->format, std::make_wformat_args(arguments...));
+						}
+					}, self.m_arguments);
+
+				if (self.m_site->newline)
+				{
+					if constexpr (std::same_as<CharT, char>)
+						message.append(logger<Writer>::c_crlf);
+					else
+						message.append(logger<Writer>::c_w_crlf);
+				}
+
+				auto& target = *static_cast<Writer*>(writer);
+				if constexpr (direct_log_writer<Writer>)
+					target.write_direct(message);
+				else
+					target.write_out(message);
+			}
+		};
+
+		// Queued by deferred_logger::exit behind that logger's records; the logger waits for it to run.
+		struct deferred_fence final : deferred_record
+		{
+			deferred_fence()
+			{
+				m_invoke = &invoke;
+			}
+
+			static void invoke(deferred_record& record, void*)
+			{
+				static_cast<deferred_fence&>(record).m_done.count_down();
+			}
+
+			std::latch m_done{ 1 };
+		};
+
+		// Queued handle to a record in some producer's arena. The record is consumed exactly once by execute(),
+		// so the handle can be moved but never copied.
+		struct deferred_work_item final
+		{
+			explicit deferred_work_item(deferred_record* record)
+				: m_record(record)
+			{
+			}
+			~deferred_work_item() = default;
+			deferred_work_item(deferred_work_item&& that) noexcept
+				: m_record(std::exchange(that.m_record, nullptr))
+			{
+			}
+			deferred_work_item& operator=(deferred_work_item&& that) noexcept
+			{
+				m_record = std::exchange(that.m_record, nullptr);
+				return *this;
+			}
+
+			deferred_work_item(deferred_work_item const&) = delete;
+			deferred_work_item& operator=(deferred_work_item const&) = delete;
+
+			void execute()
+			{
+				auto record = std::exchange(m_record, nullptr);
+				auto release = wil::scope_exit([block = record->m_block]
+				{
+					if (block)
+						block->release();
+				});
+				record->m_invoke(*record, record->m_writer);
+			}
+
+			deferred_record* m_record{};
+		};
+		static_assert(MovableWorkItem<deferred_work_item> && !std::copy_constructible<deferred_work_item>);
+	}
+
+	// Logger that moves formatting off the calling thread. The caller only copies its arguments and a pointer
+	// to a static call site into a per-thread arena; the record is formatted and written on the queue thread.
+	template <log_writer Writer, log_level MinLevel = log_level::TAZ_MIN_LOG_LEVEL>
+	struct deferred_logger final
+	{
+		static constexpr bool is_enabled(log_level level)
+		{
+			return logger<Writer, MinLevel>::is_enabled(level);
+		}
+
+		template <class... Args>
+		void write_line(log_site const& site, Args&&... args)
+		{
+			enqueue(site, std::forward<Args>(args)...);
+		}
+
+		template <class... Args>
+		void write_line(wlog_site const& site, Args&&... args)
+		{
+			enqueue(site, std::forward<Args>(args)...);
+		}
+
+		template <log_level Level, class... Args>
+		void write_line([[maybe_unused]] log_site const& site, [[maybe_unused]] Args&&... args)
+		{
+			if constexpr (is_enabled(Level))
+				enqueue(site, std::forward<Args>(args)...);
+		}
+
+		template <log_level Level, class... Args>
+		void write_line([[maybe_unused]] wlog_site const& site, [[maybe_unused]] Args&&... args)
+		{
+			if constexpr (is_enabled(Level))
+				enqueue(site, std::forward<Args>(args)...);
+		}
+
+		deferred_logger(Writer&& writer)
+			: m_writer(std::move(writer))
+		{
+			std::lock_guard lock{ s_lock };
+			if (s_stopped)
+				m_direct = true;
+			else
+				++s_instances;
+		}
+		~deferred_logger()
+		{
+			exit();
+		}
+
+		deferred_logger() = delete;
+		deferred_logger(deferred_logger const&) = delete;
+		deferred_logger(deferred_logger&&) = delete;
+		deferred_logger& operator=(deferred_logger const&) = delete;
+		deferred_logger& operator=(deferred_logger&&) = delete;
+
+		// Waits until this logger's queued records have been written, since they refer to m_writer. Every
+		// deferred_logger with the same Writer shares one queue thread, and the last one to exit stops it for
+		// good. Lines written after that, by this logger or one created later, are written on the calling thread.
+		void exit()
+		{
+			if (std::exchange(m_exited, true))
+				return;
+
+			if (!m_direct)
+			{
+				details::deferred_fence fence;
+				queue().push(details::deferred_work_item{ &fence });
+				fence.m_done.wait();
+
+				std::lock_guard lock{ s_lock };
+				if (--s_instances == 0)
+				{
+					s_stopped = true;
+					queue().exit();
+				}
+			}
+			m_writer.exit();
+		}
+
+	private:
+		template <typename CharT, class... Args>
+		void enqueue(basic_log_site<CharT> const& site, Args&&... args)
+		{
+			using record_type = details::deferred_record_of<CharT, Writer, typename details::deferred_capture_t<Args>::stored_type...>;
+
+			std::size_t extraSize = (std::size_t{} + ... + details::deferred_capture_t<Args>::extra_size(args));
+
+			details::deferred_block* block{};
+			auto memory = details::current_deferred_buffer().allocate(sizeof(record_type) + extraSize, alignof(record_type), block);
+			auto extra = memory + sizeof(record_type);
+
+			auto record = ::new (memory) record_type{ { &record_type::invoke, &m_writer, block }, &site,
+				{ details::deferred_capture_t<Args>::capture(args, extra)... } };
+
+			details::deferred_work_item workItem{ record };
+			if (m_direct || m_exited) [[unlikely]]
+				workItem.execute();
+			else
+				queue().push(std::move(workItem));
+		}
+
+		// Created on first use and never destroyed, so neither static initialization nor destruction order
+		// matters, and its thread only starts once something is logged.
+		static thread_queue<details::deferred_work_item>& queue()
+		{
+			static auto& s_queue = *new thread_queue<details::deferred_work_item>{ thread_start::on_first_push };
+			return s_queue;
+		}
+
+		// s_lock guards s_instances and s_stopped, so that a logger created while the last one exits either keeps the
+		// queue running or sees it stopped.
+		inline static std::mutex s_lock{};
+		inline static std::size_t s_instances{};
+		inline static bool s_stopped{};
+		Writer m_writer{};
+		bool m_exited{};
+		bool m_direct{};
+	};
+}
+
+// Declares the static call site and queues a deferred line in one statement.
+#define TAZ_DEFERRED_LINE(logger, format, ...) \
+	do \
+	{ \
+		static constexpr ::taz::basic_log_site tazDeferredSite{ format }; \
+		(logger).write_line(tazDeferredSite __VA_OPT__(,) __VA_ARGS__); \
+	} while (false)
@@ -50,10 +50,19 @@ namespace taz::details
 
 		auto format(const _Ty input, auto& ctx) const
 		{
-			auto output = input ? taz::string_utility::narrow(input) : std::string{};
+			auto out = ctx.out();
+			if (!input)
+				return out;
 
-			// Write it out
-			return std::copy(begin(output), end(output), ctx.out());
+			// Convert through a stack buffer so formatting never allocates.
+			taz::string_utility::inplace_string<256> buffer;
+			for (std::wstring_view remaining{ input }; !remaining.empty(); buffer.clear())
+			{
+				auto result = taz::string_utility::narrow_append(remaining, buffer);
+				out = std::copy(buffer.data(), buffer.data() + buffer.size(), out);
+				remaining.remove_prefix(result.m_read);
+			}
+			return out;
 		}
 	};
 
@@ -67,10 +76,18 @@ namespace taz::details
 
 		auto format(const _Ty input, auto& ctx) const
 		{
-			auto output = input ? taz::string_utility::widen(input) : std::wstring{};
+			auto out = ctx.out();
+			if (!input)
+				return out;
 
-			// Write it out
-			return std::copy(begin(output), end(output), ctx.out());
+			taz::string_utility::inplace_wstring<256> buffer;
+			for (std::string_view remaining{ input }; !remaining.empty(); buffer.clear())
+			{
+				auto result = taz::string_utility::widen_append(remaining, buffer);
+				out = std::copy(buffer.data(), buffer.data() + buffer.size(), out);
+				remaining.remove_prefix(result.m_read);
+			}
+			return out;
 		}
 	};
 }
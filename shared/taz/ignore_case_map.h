@@ -0,0 +1,415 @@
+#pragma once
+
+// Standard C++ headers
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// tasler-cpp headers
+#include "string_utility.h"
+
+namespace taz
+{
+	namespace details
+	{
+		// Replaces target with source's contents. The key is const, so it is copied, and copied first, so that a
+		// failed copy leaves both entries as they were.
+		template <typename Value>
+		void replace_entry(std::pair<std::wstring const, Value>& target, std::pair<std::wstring const, Value>& source)
+		{
+			std::pair<std::wstring, Value> moved{ source.first, std::move(source.second) };
+			std::destroy_at(&target);
+			std::construct_at(&target, std::move(moved));
+		}
+	}
+
+	// Open-addressing hash map for case-insensitive wide string keys (ordinal_ignore_case_equal_to). Entries
+	// live contiguously in insertion order, next to their folded hashes, and a separate power-of-two slot table
+	// of 8-byte (index, hash) pairs is probed linearly, so a lookup is one hash, a short scan of adjacent slots
+	// and normally a single key comparison. Erasing moves the last entry into the hole, so it invalidates
+	// iterators and changes iteration order; everything else only invalidates them on growth. Keys are const, as
+	// in std::unordered_map, so moving an entry copies its key; reserve() avoids that on growth.
+	template <typename Value>
+	struct ignore_case_hash_map final
+	{
+		using key_type = std::wstring;
+		using mapped_type = Value;
+		using value_type = std::pair<std::wstring const, Value>;
+		using iterator = typename std::vector<value_type>::iterator;
+		using const_iterator = typename std::vector<value_type>::const_iterator;
+
+		ignore_case_hash_map() = default;
+		~ignore_case_hash_map() = default;
+		ignore_case_hash_map(ignore_case_hash_map const&) = default;
+		ignore_case_hash_map(ignore_case_hash_map&&) = default;
+		ignore_case_hash_map& operator=(ignore_case_hash_map const& that)
+		{
+			// Entries can't be assigned, only constructed, so copy first and then take the copy.
+			return *this = ignore_case_hash_map{ that };
+		}
+		ignore_case_hash_map& operator=(ignore_case_hash_map&&) = default;
+
+		iterator begin() { return m_entries.begin(); }
+		iterator end() { return m_entries.end(); }
+		const_iterator begin() const { return m_entries.begin(); }
+		const_iterator end() const { return m_entries.end(); }
+		std::size_t size() const { return m_entries.size(); }
+		bool empty() const { return m_entries.empty(); }
+
+		void clear()
+		{
+			m_entries.clear();
+			m_hashes.clear();
+			std::fill(m_slots.begin(), m_slots.end(), slot{});
+		}
+
+		void reserve(std::size_t count)
+		{
+			m_entries.reserve(count);
+			m_hashes.reserve(count);
+			if (count > max_load(m_slots.size()))
+				rehash(std::bit_ceil(std::max<std::size_t>(count + count / 3 + 1, 8)));
+		}
+
+		iterator find(std::wstring_view key)
+		{
+			auto found = find_slot(key, hash(key));
+			return found == c_notFound ? end() : begin() + (m_slots[found].m_index - 1);
+		}
+
+		const_iterator find(std::wstring_view key) const
+		{
+			auto found = find_slot(key, hash(key));
+			return found == c_notFound ? end() : begin() + (m_slots[found].m_index - 1);
+		}
+
+		bool contains(std::wstring_view key) const { return find(key) != end(); }
+
+		template <typename... Args>
+		std::pair<iterator, bool> try_emplace(std::wstring_view key, Args&&... args)
+		{
+			auto keyHash = hash(key);
+			if (auto found = find_slot(key, keyHash); found != c_notFound)
+				return { begin() + (m_slots[found].m_index - 1), false };
+
+			if (m_entries.size() + 1 > max_load(m_slots.size()))
+				rehash(std::max<std::size_t>(m_slots.size() * 2, 8));
+
+			m_entries.emplace_back(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+			m_hashes.push_back(keyHash);
+			place(m_entries.size(), keyHash);
+			return { std::prev(end()), true };
+		}
+
+		template <typename V>
+		std::pair<iterator, bool> insert_or_assign(std::wstring_view key, V&& value)
+		{
+			auto result = try_emplace(key, std::forward<V>(value));
+			if (!result.second)
+				result.first->second = std::forward<V>(value);
+			return result;
+		}
+
+		Value& operator[](std::wstring_view key)
+		{
+			return try_emplace(key).first->second;
+		}
+
+		std::size_t erase(std::wstring_view key)
+		{
+			auto found = find_slot(key, hash(key));
+			if (found == c_notFound)
+				return 0;
+
+			auto index = m_slots[found].m_index - 1;
+			remove_slot(found);
+
+			// Move the last entry into the hole and repoint its slot.
+			auto last = m_entries.size() - 1;
+			if (index != last)
+			{
+				auto lastSlot = slot_of(last + 1, m_hashes[last]);
+				m_slots[lastSlot].m_index = static_cast<uint32_t>(index + 1);
+				details::replace_entry(m_entries[index], m_entries[last]);
+				m_hashes[index] = m_hashes[last];
+			}
+			m_entries.pop_back();
+			m_hashes.pop_back();
+			return 1;
+		}
+
+	private:
+		inline static constexpr std::size_t c_notFound = ~std::size_t{};
+
+		struct slot final
+		{
+			uint32_t m_index{};  // Entry index + 1; 0 marks an empty slot.
+			uint32_t m_hash{};
+		};
+
+		static std::size_t hash(std::wstring_view key) { return string_utility::ordinal_ignore_case_hash{}(key); }
+		static std::size_t max_load(std::size_t slots) { return slots - slots / 4; }
+
+		std::size_t find_slot(std::wstring_view key, std::size_t keyHash) const
+		{
+			if (m_slots.empty())
+				return c_notFound;
+
+			auto const mask = m_slots.size() - 1;
+			for (auto position = keyHash & mask; m_slots[position].m_index != 0; position = (position + 1) & mask)
+			{
+				auto const& candidate = m_slots[position];
+				if (candidate.m_hash == static_cast<uint32_t>(keyHash)
+					&& m_hashes[candidate.m_index - 1] == keyHash
+					&& string_utility::ordinal_ignore_case_equal_to{}(m_entries[candidate.m_index - 1].first, key))
+				{
+					return position;
+				}
+			}
+			return c_notFound;
+		}
+
+		std::size_t slot_of(std::size_t slotIndex, std::size_t keyHash) const
+		{
+			auto const mask = m_slots.size() - 1;
+			auto position = keyHash & mask;
+			while (m_slots[position].m_index != slotIndex)
+				position = (position + 1) & mask;
+			return position;
+		}
+
+		void place(std::size_t slotIndex, std::size_t keyHash)
+		{
+			auto const mask = m_slots.size() - 1;
+			auto position = keyHash & mask;
+			while (m_slots[position].m_index != 0)
+				position = (position + 1) & mask;
+			m_slots[position] = { static_cast<uint32_t>(slotIndex), static_cast<uint32_t>(keyHash) };
+		}
+
+		// Backward-shift deletion: later members of the probe run move up, so no tombstones are needed.
+		void remove_slot(std::size_t hole)
+		{
+			auto const mask = m_slots.size() - 1;
+			for (auto position = (hole + 1) & mask; m_slots[position].m_index != 0; position = (position + 1) & mask)
+			{
+				auto ideal = m_hashes[m_slots[position].m_index - 1] & mask;
+				if (((position - ideal) & mask) >= ((position - hole) & mask))
+				{
+					m_slots[hole] = m_slots[position];
+					hole = position;
+				}
+			}
+			m_slots[hole] = {};
+		}
+
+		void rehash(std::size_t slotCount)
+		{
+			m_slots.assign(slotCount, slot{});
+			for (std::size_t index = 0; index < m_entries.size(); ++index)
+				place(index + 1, m_hashes[index]);
+		}
+
+		std::vector<value_type> m_entries{};
+		std::vector<std::size_t> m_hashes{};
+		std::vector<slot> m_slots{};
+	};
+
+	// Sorted-vector map for case-insensitive wide string keys, ordered as ordinal_ignore_case_less. Beside each
+	// key it keeps the first folded code units packed into one integer, which orders the same way, so a binary
+	// search compares integers in one contiguous array and only compares strings when those prefixes tie.
+	// Inserting and erasing rebuild the arrays, copying every key behind the change since keys are const, so it
+	// suits tables built once and then read, such as a snapshot.
+	template <typename Value>
+	struct ignore_case_flat_map final
+	{
+		using key_type = std::wstring;
+		using mapped_type = Value;
+		using value_type = std::pair<std::wstring const, Value>;
+		using iterator = typename std::vector<value_type>::iterator;
+		using const_iterator = typename std::vector<value_type>::const_iterator;
+
+		ignore_case_flat_map() = default;
+		~ignore_case_flat_map() = default;
+		ignore_case_flat_map(ignore_case_flat_map const&) = default;
+		ignore_case_flat_map(ignore_case_flat_map&&) = default;
+		ignore_case_flat_map& operator=(ignore_case_flat_map const& that)
+		{
+			// Entries can't be assigned, only constructed, so copy first and then take the copy.
+			return *this = ignore_case_flat_map{ that };
+		}
+		ignore_case_flat_map& operator=(ignore_case_flat_map&&) = default;
+
+		// Builds the map in one sort, moving the keys in. For duplicate keys the first one in entries is kept.
+		explicit ignore_case_flat_map(std::vector<std::pair<std::wstring, Value>> entries)
+		{
+			using entry_type = std::pair<std::wstring, Value>;
+			std::stable_sort(entries.begin(), entries.end(), [](entry_type const& left, entry_type const& right)
+			{
+				return string_utility::ordinal_ignore_case_less{}(left.first, right.first);
+			});
+			auto duplicates = std::unique(entries.begin(), entries.end(), [](entry_type const& left, entry_type const& right)
+			{
+				return string_utility::ordinal_ignore_case_equal_to{}(left.first, right.first);
+			});
+			entries.erase(duplicates, entries.end());
+
+			m_entries.reserve(entries.size());
+			m_prefixes.reserve(entries.size());
+			for (auto& entry : entries)
+			{
+				m_prefixes.push_back(prefix(entry.first));
+				m_entries.emplace_back(std::move(entry));
+			}
+		}
+
+		iterator begin() { return m_entries.begin(); }
+		iterator end() { return m_entries.end(); }
+		const_iterator begin() const { return m_entries.begin(); }
+		const_iterator end() const { return m_entries.end(); }
+		std::size_t size() const { return m_entries.size(); }
+		bool empty() const { return m_entries.empty(); }
+
+		void clear()
+		{
+			m_entries.clear();
+			m_prefixes.clear();
+		}
+
+		void reserve(std::size_t count)
+		{
+			m_entries.reserve(count);
+			m_prefixes.reserve(count);
+		}
+
+		iterator lower_bound(std::wstring_view key) { return begin() + lower_bound_index(key, prefix(key)); }
+		const_iterator lower_bound(std::wstring_view key) const { return begin() + lower_bound_index(key, prefix(key)); }
+
+		iterator find(std::wstring_view key) { return begin() + find_index(key); }
+		const_iterator find(std::wstring_view key) const { return begin() + find_index(key); }
+
+		bool contains(std::wstring_view key) const { return find(key) != end(); }
+
+		template <typename... Args>
+		std::pair<iterator, bool> try_emplace(std::wstring_view key, Args&&... args)
+		{
+			auto keyPrefix = prefix(key);
+			auto index = lower_bound_index(key, keyPrefix);
+			if (index != m_entries.size() && string_utility::ordinal_ignore_case_equal_to{}(m_entries[index].first, key))
+				return { begin() + index, false };
+
+			if (index == m_entries.size())
+			{
+				m_entries.emplace_back(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+			}
+			else
+			{
+				std::vector<value_type> entries;
+				entries.reserve(m_entries.size() + 1);
+				std::move(begin(), begin() + index, std::back_inserter(entries));
+				entries.emplace_back(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+				std::move(begin() + index, end(), std::back_inserter(entries));
+				m_entries = std::move(entries);
+			}
+			m_prefixes.insert(m_prefixes.begin() + index, keyPrefix);
+			return { begin() + index, true };
+		}
+
+		template <typename V>
+		std::pair<iterator, bool> insert_or_assign(std::wstring_view key, V&& value)
+		{
+			auto result = try_emplace(key, std::forward<V>(value));
+			if (!result.second)
+				result.first->second = std::forward<V>(value);
+			return result;
+		}
+
+		Value& operator[](std::wstring_view key)
+		{
+			return try_emplace(key).first->second;
+		}
+
+		std::size_t erase(std::wstring_view key)
+		{
+			auto index = find_index(key);
+			if (index == m_entries.size())
+				return 0;
+
+			if (index + 1 != m_entries.size())
+			{
+				std::vector<value_type> entries;
+				entries.reserve(m_entries.size() - 1);
+				std::move(begin(), begin() + index, std::back_inserter(entries));
+				std::move(begin() + index + 1, end(), std::back_inserter(entries));
+				m_entries = std::move(entries);
+			}
+			else
+			{
+				m_entries.pop_back();
+			}
+			m_prefixes.erase(m_prefixes.begin() + index);
+			return 1;
+		}
+
+	private:
+		inline static constexpr std::size_t c_prefixUnits = sizeof(uint64_t) / sizeof(wchar_t);
+
+		// The first c_prefixUnits folded units, most significant first and zero padded. A shorter key that is a
+		// prefix of a longer one packs no higher than it, so integer order never contradicts string order.
+		static uint64_t prefix(std::wstring_view key)
+		{
+			uint64_t packed{};
+			for (std::size_t index = 0; index < c_prefixUnits; ++index)
+			{
+				auto unit = index < key.size() ? static_cast<uint64_t>(static_cast<std::make_unsigned_t<wchar_t>>(string_utility::fold_case(key[index]))) : 0;
+				packed = (packed << (sizeof(wchar_t) * 8)) | unit;
+			}
+			return packed;
+		}
+
+		std::size_t lower_bound_index(std::wstring_view key, uint64_t keyPrefix) const
+		{
+			std::size_t first{};
+			std::size_t count = m_entries.size();
+			while (count > 0)
+			{
+				auto half = count / 2;
+				auto middle = first + half;
+				auto less = m_prefixes[middle] != keyPrefix
+					? m_prefixes[middle] < keyPrefix
+					: string_utility::compare_ignore_case(m_entries[middle].first, key) < 0;
+				if (less)
+				{
+					first = middle + 1;
+					count -= half + 1;
+				}
+				else
+				{
+					count = half;
+				}
+			}
+			return first;
+		}
+
+		std::size_t find_index(std::wstring_view key) const
+		{
+			auto keyPrefix = prefix(key);
+			auto index = lower_bound_index(key, keyPrefix);
+			if (index != m_entries.size() && m_prefixes[index] == keyPrefix && string_utility::ordinal_ignore_case_equal_to{}(m_entries[index].first, key))
+				return index;
+			return m_entries.size();
+		}
+
+		std::vector<value_type> m_entries{};
+		std::vector<uint64_t> m_prefixes{};
+	};
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+// Standard C++ headers
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// tasler-cpp headers
+#include "work_item.h"
+
+namespace taz
+{
+	// Move-only, type-erased nullary callable stored entirely inline. Unlike std::function it never allocates:
+	// a callable that doesn't fit in Capacity bytes is rejected at compile time rather than moved to the heap.
+	template <std::size_t Capacity = 6 * sizeof(void*)>
+	struct inplace_task final
+	{
+		inline static constexpr std::size_t c_capacity = Capacity;
+
+		template <typename F>
+		inline static constexpr bool fits = sizeof(F) <= Capacity
+			&& alignof(F) <= alignof(std::max_align_t)
+			&& std::is_nothrow_move_constructible_v<F>;
+
+		inplace_task() = default;
+
+		template <typename F>
+			requires (!std::same_as<std::remove_cvref_t<F>, inplace_task>) && std::invocable<std::decay_t<F>&>
+		inplace_task(F&& callable)
+		{
+			using callable_type = std::decay_t<F>;
+			static_assert(fits<callable_type>, "The callable is too large for this inplace_task; increase Capacity.");
+
+			::new (static_cast<void*>(m_storage)) callable_type(std::forward<F>(callable));
+			m_operations = &s_operations<callable_type>;
+		}
+
+		inplace_task(inplace_task&& that) noexcept
+		{
+			move_from(that);
+		}
+		inplace_task& operator=(inplace_task&& that) noexcept
+		{
+			if (this != &that)
+			{
+				reset();
+				move_from(that);
+			}
+			return *this;
+		}
+		~inplace_task()
+		{
+			reset();
+		}
+
+		inplace_task(inplace_task const&) = delete;
+		inplace_task& operator=(inplace_task const&) = delete;
+
+		void execute()
+		{
+			m_operations->m_invoke(m_storage);
+		}
+
+		void operator()()
+		{
+			execute();
+		}
+
+		explicit operator bool() const { return m_operations != nullptr; }
+
+		void reset()
+		{
+			if (auto operations = std::exchange(m_operations, nullptr))
+				operations->m_destroy(m_storage);
+		}
+
+	private:
+		struct operations final
+		{
+			void (*m_invoke)(void*);
+			void (*m_relocate)(void* destination, void* source) noexcept;
+			void (*m_destroy)(void*) noexcept;
+		};
+
+		template <typename F>
+		inline static constexpr operations s_operations
+		{
+			[](void* storage) { std::invoke(*static_cast<F*>(storage)); },
+			[](void* destination, void* source) noexcept
+			{
+				auto from = static_cast<F*>(source);
+				::new (destination) F(std::move(*from));
+				from->~F();
+			},
+			[](void* storage) noexcept { static_cast<F*>(storage)->~F(); },
+		};
+
+		void move_from(inplace_task& that) noexcept
+		{
+			if (that.m_operations)
+			{
+				that.m_operations->m_relocate(m_storage, that.m_storage);
+				m_operations = std::exchange(that.m_operations, nullptr);
+			}
+		}
+
+		alignas(std::max_align_t) std::byte m_storage[Capacity];
+		operations const* m_operations{};
+	};
+	static_assert(MovableWorkItem<inplace_task<>>);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+// Standard C++ headers
+#include <cstdint>
+#include <type_traits>
+
+// Minimum severity compiled into loggers that don't specify one, e.g. /DTAZ_MIN_LOG_LEVEL=warning.
+#if !defined(TAZ_MIN_LOG_LEVEL)
+#define TAZ_MIN_LOG_LEVEL trace
+#endif
+
+namespace taz
+{
+	enum class log_level : uint8_t
+	{
+		trace,
+		debug,
+		info,
+		warning,
+		error,
+		critical,
+		off,
+	};
+
+	// Whether a logger compiled with minLevel keeps statements of the given level.
+	constexpr bool is_log_level_enabled(log_level level, log_level minLevel)
+	{
+		return level != log_level::off && level >= minLevel;
+	}
+}
+
+// Writes a line at the given severity. When the level is below the logger's compile-time minimum the whole
+// statement, including the evaluation of its arguments, is discarded.
+#define TAZ_LOG(logger, level, ...) \
+	do \
+	{ \
+		if constexpr (std::remove_cvref_t<decltype(logger)>::is_enabled(::taz::log_level::level)) \
+		{ \
+			(logger).write_line(__VA_ARGS__); \
+		} \
+	} while (false)
+
+// Same as TAZ_LOG, but also skips the statement at run time when the category's threshold is above the level.
+#define TAZ_LOG_CATEGORY(logger, category, level, ...) \
+	do \
+	{ \
+		if constexpr (std::remove_cvref_t<decltype(logger)>::is_enabled(::taz::log_level::level)) \
+		{ \
+			if ((category).is_enabled(::taz::log_level::level)) \
+			{ \
+				(logger).write_line(__VA_ARGS__); \
+			} \
+		} \
+	} while (false)
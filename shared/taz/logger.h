@@ -1,19 +1,159 @@
 #pragma once
 
 // Standard C++ headers
+#include <atomic>
 #include <concepts>
+#include <cstdint>
 #include <format>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 // Local headers
 #include "formatters.h"
+#include "log_level.h"
+
+// WIL headers
+#include <wil/resource.h>
 
 using namespace std::literals;
 
 namespace taz
 {
+	// A runtime-adjustable verbosity threshold for one subsystem. Call sites refer to the category object
+	// directly, so a disabled check is one relaxed load and one branch. Categories register themselves with
+	// log_categories on construction and are expected to have static storage duration.
+	struct log_category final
+	{
+		log_category(std::wstring_view name, log_level threshold = log_level::info);
+		~log_category();
+
+		log_category(log_category const&) = delete;
+		log_category(log_category&&) = delete;
+		log_category& operator=(log_category const&) = delete;
+		log_category& operator=(log_category&&) = delete;
+
+		bool is_enabled(log_level level) const
+		{
+			return level >= m_threshold.load(std::memory_order_relaxed);
+		}
+
+		log_level threshold() const { return m_threshold.load(std::memory_order_relaxed); }
+		void set_threshold(log_level threshold) { m_threshold.store(threshold, std::memory_order_release); }
+		std::wstring_view name() const { return m_name; }
+
+	private:
+		friend struct log_categories;
+
+		enum class unregistered_t { };
+		inline static constexpr unregistered_t unregistered{};
+
+		log_category(std::wstring_view name, log_level threshold, unregistered_t)
+			: m_threshold(threshold)
+			, m_name(name)
+		{
+		}
+
+		std::atomic<log_level> m_threshold;
+		std::wstring m_name;
+	};
+
+	// Registry of every live log_category, used to change thresholds by name. Only registration and lookups by
+	// name take the lock; the logging hot path never touches it.
+	struct log_categories final
+	{
+		log_categories() = delete;
+		log_categories(log_categories const&) = delete;
+		log_categories(log_categories&&) = delete;
+		~log_categories() = delete;
+		log_categories& operator=(log_categories const&) = delete;
+		log_categories& operator=(log_categories&&) = delete;
+
+		// Returns the category with the given name, creating a registry-owned one if none exists yet. The
+		// result is stable for the life of the process, so callers should cache it.
+		static log_category& get(std::wstring_view name, log_level threshold = log_level::info)
+		{
+			{
+				auto lock = s_lock.lock_shared();
+				if (auto category = find_locked(name))
+					return *category;
+			}
+
+			auto lock = s_lock.lock_exclusive();
+			if (auto category = find_locked(name))
+				return *category;
+
+			// Registry-owned categories skip the self-registration because we're already holding the lock.
+			auto& category = *s_owned.emplace_back(new log_category(name, threshold, log_category::unregistered));
+			s_categories.push_back(&category);
+			return category;
+		}
+
+		static log_category* find(std::wstring_view name)
+		{
+			auto lock = s_lock.lock_shared();
+			return find_locked(name);
+		}
+
+		static bool set_threshold(std::wstring_view name, log_level threshold)
+		{
+			auto lock = s_lock.lock_shared();
+			auto category = find_locked(name);
+			if (category)
+				category->set_threshold(threshold);
+			return category != nullptr;
+		}
+
+		static void set_all_thresholds(log_level threshold)
+		{
+			auto lock = s_lock.lock_shared();
+			for (auto category : s_categories)
+				category->set_threshold(threshold);
+		}
+
+		template <std::invocable<log_category&> Callback>
+		static void for_each(Callback&& callback)
+		{
+			auto lock = s_lock.lock_shared();
+			for (auto category : s_categories)
+				callback(*category);
+		}
+
+	private:
+		friend struct log_category;
+
+		static log_category* find_locked(std::wstring_view name)
+		{
+			for (auto category : s_categories)
+			{
+				if (category->name() == name)
+					return category;
+			}
+			return nullptr;
+		}
+
+		inline static wil::srwlock s_lock{};
+		inline static std::vector<log_category*> s_categories{};
+		inline static std::vector<std::unique_ptr<log_category>> s_owned{};
+	};
+
+	inline log_category::log_category(std::wstring_view name, log_level threshold)
+		: m_threshold(threshold)
+		, m_name(name)
+	{
+		auto lock = log_categories::s_lock.lock_exclusive();
+		log_categories::s_categories.push_back(this);
+	}
+
+	inline log_category::~log_category()
+	{
+		auto lock = log_categories::s_lock.lock_exclusive();
+		std::erase(log_categories::s_categories, this);
+	}
+
 	template <typename Writer>
 	concept log_writer = (std::copy_constructible<Writer> || std::move_constructible<Writer>) && requires(Writer w)
 	{
@@ -23,11 +163,68 @@ namespace taz
 	};
 
 
-	template <log_writer Writer>
+	template <log_writer Writer, log_level MinLevel = log_level::TAZ_MIN_LOG_LEVEL>
 	struct logger final
 	{
 		inline static constexpr auto c_crlf = "\r\n"sv;
 		inline static constexpr auto c_w_crlf = L"\r\n"sv;
+		inline static constexpr auto c_minLevel = MinLevel;
+
+		static constexpr bool is_enabled(log_level level)
+		{
+			return is_log_level_enabled(level, MinLevel);
+		}
+
+		// Severity-tagged entry points. Below MinLevel these are empty, but the arguments have already been
+		// evaluated by the caller; use TAZ_LOG to elide the argument expressions as well.
+		template <log_level Level, class... Args>
+		void write_line([[maybe_unused]] std::string_view fmt, [[maybe_unused]] Args&&... args)
+		{
+			if constexpr (is_enabled(Level))
+				write_line(fmt, std::forward<Args>(args)...);
+		}
+
+		template <log_level Level, class... Args>
+		void write_line([[maybe_unused]] std::wstring_view fmt, [[maybe_unused]] Args&&... args)
+		{
+			if constexpr (is_enabled(Level))
+				write_line(fmt, std::forward<Args>(args)...);
+		}
+
+		template <log_level Level, class... Args>
+		void write([[maybe_unused]] std::string_view fmt, [[maybe_unused]] Args&&... args)
+		{
+			if constexpr (is_enabled(Level))
+				write(fmt, std::forward<Args>(args)...);
+		}
+
+		template <log_level Level, class... Args>
+		void write([[maybe_unused]] std::wstring_view fmt, [[maybe_unused]] Args&&... args)
+		{
+			if constexpr (is_enabled(Level))
+				write(fmt, std::forward<Args>(args)...);
+		}
+
+		// Severity-tagged entry points that are also filtered by a category's runtime threshold.
+		template <log_level Level, class... Args>
+		void write_line([[maybe_unused]] log_category const& category, [[maybe_unused]] std::string_view fmt, [[maybe_unused]] Args&&... args)
+		{
+			if constexpr (is_enabled(Level))
+			{
+				if (category.is_enabled(Level))
+					write_line(fmt, std::forward<Args>(args)...);
+			}
+		}
+
+		template <log_level Level, class... Args>
+		void write_line([[maybe_unused]] log_category const& category, [[maybe_unused]] std::wstring_view fmt, [[maybe_unused]] Args&&... args)
+		{
+			if constexpr (is_enabled(Level))
+			{
+				if (category.is_enabled(Level))
+					write_line(fmt, std::forward<Args>(args)...);
+			}
+		}
 
 		template< class... Args >
 		void write_line([[maybe_unused]] std::string_view fmt, [[maybe_unused]] Args&&... args)
@@ -0,0 +1,203 @@
+#pragma once
+
+// Standard C++ headers
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <optional>
+#include <ranges>
+#include <utility>
+
+// tasler-cpp headers
+#include "range_utility.h"
+
+namespace taz
+{
+	// Intrusive multi-producer/single-consumer queue (Vyukov). push() is a single atomic exchange plus a store
+	// and never waits on the consumer; try_pop() must only be called from one thread at a time. A pop may
+	// briefly report empty while a producer is between its exchange and its link, so consumers must be woken
+	// by the producer after push() returns rather than relying on a single pass to see every item.
+	// Items are stored by value, so the link cannot live in T itself; instead nodes are recycled through
+	// node_pool, and once the pool has warmed up neither side touches the allocator.
+	template <std::move_constructible T>
+	struct mpsc_queue final
+	{
+		mpsc_queue() = default;
+		~mpsc_queue()
+		{
+			while (try_pop())
+			{
+			}
+		}
+
+		mpsc_queue(mpsc_queue const&) = delete;
+		mpsc_queue(mpsc_queue&&) = delete;
+		mpsc_queue& operator=(mpsc_queue const&) = delete;
+		mpsc_queue& operator=(mpsc_queue&&) = delete;
+
+		void push(T&& item)
+		{
+			push_node(node_pool::acquire(std::move(item)));
+		}
+
+		// Links the whole range privately and publishes it with a single exchange. Elements are moved only out of
+		// an rvalue range. Returns how many were queued, which is always all of them.
+		template <std::ranges::input_range R>
+		std::size_t push_range(R&& items)
+		{
+			node* first{};
+			node* last{};
+			std::size_t count{};
+			for (auto&& item : items)
+			{
+				auto current = node_pool::acquire(T(forward_element<R>(std::forward<decltype(item)>(item))));
+				if (last)
+					last->m_next.store(current, std::memory_order_relaxed);
+				else
+					first = current;
+				last = current;
+				++count;
+			}
+
+			if (first)
+			{
+				auto previous = m_head.exchange(last, std::memory_order_acq_rel);
+				previous->m_next.store(first, std::memory_order_release);
+			}
+			return count;
+		}
+
+		std::optional<T> try_pop()
+		{
+			auto node = pop_node();
+			if (!node)
+				return std::nullopt;
+
+			auto valueNode = static_cast<value_node*>(node);
+			std::optional<T> result{ std::move(valueNode->m_value) };
+			node_pool::release(valueNode);
+			return result;
+		}
+
+		// Only a hint: producers may be mid-push when this returns true.
+		bool empty() const
+		{
+			return m_tail == &m_stub && !m_stub.m_next.load(std::memory_order_acquire);
+		}
+
+	private:
+		struct node
+		{
+			std::atomic<node*> m_next{};
+		};
+
+		struct value_node final : node
+		{
+			std::optional<T> m_value{};
+		};
+
+		// Shared by every mpsc_queue<T>. Consumers push spent nodes onto one stack; a producer whose own cache
+		// is empty takes the whole stack with a single exchange. Nodes never leave the stack one at a time, so
+		// it is free of ABA without tags or hazard pointers.
+		struct node_pool final
+		{
+			static value_node* acquire(T&& item)
+			{
+				auto& cache = t_cache.m_first;
+				if (!cache)
+					cache = s_returned.exchange(nullptr, std::memory_order_acquire);
+
+				value_node* result{};
+				if (cache)
+				{
+					result = cache;
+					cache = static_cast<value_node*>(cache->m_next.load(std::memory_order_relaxed));
+					result->m_next.store(nullptr, std::memory_order_relaxed);
+				}
+				else
+				{
+					result = new value_node{};
+				}
+
+				result->m_value.emplace(std::move(item));
+				return result;
+			}
+
+			static void release(value_node* item)
+			{
+				item->m_value.reset();
+				auto head = s_returned.load(std::memory_order_relaxed);
+				do
+				{
+					item->m_next.store(head, std::memory_order_relaxed);
+				} while (!s_returned.compare_exchange_weak(head, item, std::memory_order_release, std::memory_order_relaxed));
+			}
+
+		private:
+			struct thread_cache final
+			{
+				~thread_cache()
+				{
+					while (m_first)
+					{
+						delete std::exchange(m_first, static_cast<value_node*>(m_first->m_next.load(std::memory_order_relaxed)));
+					}
+				}
+
+				value_node* m_first{};
+			};
+
+			inline static thread_local thread_cache t_cache{};
+			// Reachable until exit; whatever is left here then is reclaimed with the process.
+			inline static std::atomic<value_node*> s_returned{};
+		};
+
+		void push_node(node* item)
+		{
+			item->m_next.store(nullptr, std::memory_order_relaxed);
+			auto previous = m_head.exchange(item, std::memory_order_acq_rel);
+			previous->m_next.store(item, std::memory_order_release);
+		}
+
+		node* pop_node()
+		{
+			auto tail = m_tail;
+			auto next = tail->m_next.load(std::memory_order_acquire);
+
+			if (tail == &m_stub)
+			{
+				if (!next)
+					return nullptr;
+
+				m_tail = next;
+				tail = next;
+				next = next->m_next.load(std::memory_order_acquire);
+			}
+
+			if (next)
+			{
+				m_tail = next;
+				return tail;
+			}
+
+			// A producer has swapped the head but not linked its node yet.
+			if (tail != m_head.load(std::memory_order_acquire))
+				return nullptr;
+
+			// tail is the last node; re-insert the stub behind it so it can be handed out.
+			push_node(&m_stub);
+			next = tail->m_next.load(std::memory_order_acquire);
+			if (next)
+			{
+				m_tail = next;
+				return tail;
+			}
+
+			return nullptr;
+		}
+
+		node m_stub{};
+		alignas(64) std::atomic<node*> m_head{ &m_stub };
+		alignas(64) node* m_tail{ &m_stub };
+	};
+}
@@ -0,0 +1,284 @@
+#pragma once
+
+// Standard C++ headers
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// tasler-cpp headers
+#include "inplace_task.h"
+#include "string_replacer.h"
+#include "string_utility.h"
+#include "thread_pool.h"
+#include "utf.h"
+
+// Parallel versions of widen, narrow and basic_replacer::replace_all for multi-megabyte inputs. The input is
+// split into one chunk per worker plus one for the caller, every chunk is processed on the pool, and the
+// pieces are written straight into a single output buffer. Results are identical to the serial versions.
+namespace taz::string_utility
+{
+	using string_pool = thread_pool<inplace_task<>>;
+
+	// Below this many code units per chunk the hand-off costs more than it saves, so fewer chunks are used.
+	inline constexpr std::size_t c_parallelMinimumChunk = 64 * 1024;
+
+	namespace details
+	{
+		// Calls fn(index) for every index in [0, count) on the pool and on the calling thread. Indices are
+		// claimed from one shared counter, and the caller waits only for helpers that actually started claiming:
+		// a helper still queued when the work runs out finds nothing left and returns without touching fn. So
+		// this never waits on the pool, even when the caller is a worker or every worker calls it at once. The
+		// first exception thrown by fn is rethrown once every index has been processed.
+		template <typename Fn>
+		void parallel_for(string_pool& pool, std::size_t count, Fn const& fn)
+		{
+			// Owned jointly with the helpers, which may start after this call has returned.
+			struct shared_state final
+			{
+				void run()
+				{
+					for (auto index = m_next.fetch_add(1); index < m_count; index = m_next.fetch_add(1))
+					{
+						try
+						{
+							(*m_fn)(index);
+						}
+						catch (...)
+						{
+							std::lock_guard lock{ m_exceptionLock };
+							if (!m_exception)
+								m_exception = std::current_exception();
+						}
+					}
+				}
+
+				Fn const* m_fn{};
+				std::size_t m_count{};
+				std::atomic<std::size_t> m_next{};
+				std::atomic<std::size_t> m_active{};
+				std::mutex m_exceptionLock{};
+				std::exception_ptr m_exception{};
+			};
+
+			auto state = std::make_shared<shared_state>();
+			state->m_fn = &fn;
+			state->m_count = count;
+
+			auto helpers = std::min(count - 1, pool.worker_count());
+			for (std::size_t helper = 0; helper < helpers; ++helper)
+			{
+				pool.push(inplace_task<>{ [state]
+				{
+					// Registering before claiming means the caller, which only checks m_active once every index
+					// has been claimed, sees any helper that might still be running fn.
+					state->m_active.fetch_add(1);
+					state->run();
+					if (state->m_active.fetch_sub(1) == 1)
+						state->m_active.notify_all();
+				} });
+			}
+
+			state->run();
+			for (auto active = state->m_active.load(); active != 0; active = state->m_active.load())
+			{
+				state->m_active.wait(active);
+			}
+
+			if (state->m_exception)
+			{
+				std::rethrow_exception(state->m_exception);
+			}
+		}
+
+		inline std::size_t chunk_count(string_pool const& pool, std::size_t length)
+		{
+			return std::clamp<std::size_t>(length / c_parallelMinimumChunk, 1, pool.worker_count() + 1);
+		}
+
+		// Evenly spaced boundaries, each moved forward by adjust() to the next position that is safe to split at.
+		template <typename Adjust>
+		std::vector<std::size_t> chunk_boundaries(std::size_t length, std::size_t chunks, Adjust&& adjust)
+		{
+			std::vector<std::size_t> boundaries(chunks + 1);
+			for (std::size_t chunk = 1; chunk < chunks; ++chunk)
+			{
+				boundaries[chunk] = std::max(boundaries[chunk - 1], adjust(length / chunks * chunk));
+			}
+			boundaries[chunks] = length;
+			return boundaries;
+		}
+
+		// Splits before a byte that is not a continuation byte. No sequence, valid or not, extends across such a
+		// byte, so each chunk decodes exactly as it would as part of the whole.
+		inline std::vector<std::size_t> utf8_boundaries(std::string_view text, std::size_t chunks)
+		{
+			return chunk_boundaries(text.size(), chunks, [&](std::size_t position)
+			{
+				while (position < text.size() && (static_cast<unsigned char>(text[position]) & 0xC0) == 0x80)
+					++position;
+				return position;
+			});
+		}
+
+		// Splits anywhere but before a low surrogate, so surrogate pairs stay together.
+		inline std::vector<std::size_t> wide_boundaries(std::wstring_view text, std::size_t chunks)
+		{
+			return chunk_boundaries(text.size(), chunks, [&](std::size_t position)
+			{
+				if constexpr (sizeof(wchar_t) == 2)
+				{
+					if (position < text.size() && text[position] >= 0xDC00 && text[position] <= 0xDFFF)
+						++position;
+				}
+				return position;
+			});
+		}
+	}
+
+	inline std::wstring parallel_widen(std::string_view multibyteText, string_pool& pool)
+	{
+		auto chunks = details::chunk_count(pool, multibyteText.size());
+		if (chunks == 1)
+			return widen(multibyteText);
+
+		// Measure every chunk, then convert each straight into its place in the result.
+		auto boundaries = details::utf8_boundaries(multibyteText, chunks);
+		auto chunk = [&](std::size_t index) { return multibyteText.substr(boundaries[index], boundaries[index + 1] - boundaries[index]); };
+
+		std::vector<std::size_t> offsets(chunks + 1);
+		details::parallel_for(pool, chunks, [&](std::size_t index) { offsets[index + 1] = utf::wide_length<wchar_t>(chunk(index)); });
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+		std::wstring wideText(offsets.back(), L'\0');
+		details::parallel_for(pool, chunks, [&](std::size_t index)
+		{
+			utf::utf8_to_wide(chunk(index), std::span{ wideText }.subspan(offsets[index], offsets[index + 1] - offsets[index]));
+		});
+		return wideText;
+	}
+
+	inline std::string parallel_narrow(std::wstring_view wideText, string_pool& pool)
+	{
+		auto chunks = details::chunk_count(pool, wideText.size());
+		if (chunks == 1)
+			return narrow(wideText);
+
+		auto boundaries = details::wide_boundaries(wideText, chunks);
+		auto chunk = [&](std::size_t index) { return wideText.substr(boundaries[index], boundaries[index + 1] - boundaries[index]); };
+
+		std::vector<std::size_t> offsets(chunks + 1);
+		details::parallel_for(pool, chunks, [&](std::size_t index) { offsets[index + 1] = utf::utf8_length(chunk(index)); });
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+		std::string multibyteText(offsets.back(), '\0');
+		details::parallel_for(pool, chunks, [&](std::size_t index)
+		{
+			utf::wide_to_utf8(chunk(index), std::span{ multibyteText }.subspan(offsets[index], offsets[index + 1] - offsets[index]));
+		});
+		return multibyteText;
+	}
+
+	// Each chunk runs the greedy match from its own start. The true run enters a chunk where the previous one
+	// left off, which is later than the chunk's start when a match crossed the boundary; if the chunk's own run
+	// also passed through that position the two coincide from there on, and otherwise the chunk is rescanned
+	// from the true position. Only the rare rescans are serial.
+	template <typename CharT>
+	std::basic_string<CharT> parallel_replace_all(basic_replacer<CharT> const& replacer, std::type_identity_t<std::basic_string_view<CharT>> text, string_pool& pool)
+	{
+		auto chunks = details::chunk_count(pool, text.size());
+		if (chunks == 1 || replacer.empty())
+			return replacer.replace_all(text);
+
+		auto boundaries = details::chunk_boundaries(text.size(), chunks, [](std::size_t position) { return position; });
+
+		struct chunk_matches final
+		{
+			std::vector<std::pair<std::size_t, uint32_t>> m_matches{};
+			std::size_t m_entry{};
+			std::size_t m_exit{};
+		};
+		std::vector<chunk_matches> results(chunks);
+
+		auto scan = [&](chunk_matches& result, std::size_t from, std::size_t limit)
+		{
+			result.m_matches.clear();
+			result.m_entry = from;
+			result.m_exit = replacer.for_each_match(text, from, limit, [&](std::size_t start, uint32_t pattern)
+			{
+				result.m_matches.emplace_back(start, pattern);
+			});
+		};
+
+		details::parallel_for(pool, chunks, [&](std::size_t index) { scan(results[index], boundaries[index], boundaries[index + 1]); });
+
+		std::size_t cursor{};
+		for (std::size_t index = 0; index < chunks; ++index)
+		{
+			auto& result = results[index];
+			if (cursor >= boundaries[index + 1])
+			{
+				// Swallowed whole by a match from an earlier chunk.
+				result.m_matches.clear();
+				result.m_entry = result.m_exit = cursor;
+				continue;
+			}
+
+			if (cursor != result.m_entry)
+			{
+				auto first = std::lower_bound(result.m_matches.begin(), result.m_matches.end(), cursor,
+					[](auto const& match, std::size_t position) { return match.first < position; });
+				auto visited = first == result.m_matches.begin()
+					|| std::prev(first)->first + replacer.pattern_length(std::prev(first)->second) <= cursor;
+
+				if (visited)
+				{
+					result.m_matches.erase(result.m_matches.begin(), first);
+					result.m_entry = cursor;
+				}
+				else
+				{
+					scan(result, cursor, boundaries[index + 1]);
+				}
+			}
+			cursor = result.m_exit;
+		}
+
+		std::vector<std::size_t> offsets(chunks + 1);
+		for (std::size_t index = 0; index < chunks; ++index)
+		{
+			auto const& result = results[index];
+			auto length = result.m_exit - result.m_entry;
+			for (auto const& [start, pattern] : result.m_matches)
+				length = length - replacer.pattern_length(pattern) + replacer.replacement(pattern).size();
+			offsets[index + 1] = offsets[index] + length;
+		}
+
+		std::basic_string<CharT> output(offsets.back(), CharT{});
+		details::parallel_for(pool, chunks, [&](std::size_t index)
+		{
+			auto const& result = results[index];
+			auto out = output.data() + offsets[index];
+			auto literalStart = result.m_entry;
+			for (auto const& [start, pattern] : result.m_matches)
+			{
+				out = std::copy(text.begin() + literalStart, text.begin() + start, out);
+				auto replacement = replacer.replacement(pattern);
+				out = std::copy(replacement.begin(), replacement.end(), out);
+				literalStart = start + replacer.pattern_length(pattern);
+			}
+			std::copy(text.begin() + literalStart, text.begin() + result.m_exit, out);
+		});
+		return output;
+	}
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+// Standard C++ headers
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// MSVC accepts [[no_unique_address]] but ignores it; only its own spelling lets an empty member take no space.
+#if defined(_MSC_VER)
+#define TAZ_NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+#else
+#define TAZ_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
+
+namespace taz
+{
+	// Power-of-two latency buckets: bucket i counts durations of [2^(i-1), 2^i) nanoseconds, and the last
+	// bucket also takes everything longer.
+	struct latency_histogram_snapshot final
+	{
+		inline static constexpr std::size_t c_bucketCount = 40;
+
+		static constexpr std::chrono::nanoseconds bucket_upper_bound(std::size_t bucket)
+		{
+			return std::chrono::nanoseconds{ int64_t{ 1 } << bucket };
+		}
+
+		uint64_t count() const
+		{
+			uint64_t total{};
+			for (auto bucket : m_buckets)
+				total += bucket;
+			return total;
+		}
+
+		std::array<uint64_t, c_bucketCount> m_buckets{};
+	};
+
+	struct queue_metrics_snapshot final
+	{
+		uint64_t m_depth{};
+		uint64_t m_highWaterDepth{};
+		uint64_t m_enqueued{};
+		uint64_t m_executed{};
+		uint64_t m_evicted{};
+		uint64_t m_exceptions{};
+		latency_histogram_snapshot m_queueLatency{};
+		latency_histogram_snapshot m_executeDuration{};
+	};
+
+	// thread_queue metrics policy that records nothing. Every hook is empty and work items are stored as-is,
+	// so a queue using it is identical to an uninstrumented one.
+	struct no_queue_metrics final
+	{
+		inline static constexpr bool c_enabled = false;
+
+		struct time_point final
+		{
+		};
+
+		template <typename T>
+		using entry = T;
+
+		template <typename T>
+		static T make_entry(T&& workItem) { return std::move(workItem); }
+
+		template <typename T>
+		static T& work_item(T& entry) { return entry; }
+
+		void on_enqueue(std::size_t = 1) {}
+		void on_dropped() {}
+		void on_evicted(std::size_t) {}
+		template <typename T>
+		void on_dequeue(T const&) {}
+		time_point start_execute() const { return {}; }
+		void on_executed(time_point, std::size_t = 1) {}
+		void on_exception() {}
+	};
+
+	// thread_queue metrics policy that stamps every item at enqueue time and keeps depth, high-water depth,
+	// enqueue-to-execute latency, execute duration, and eviction and exception counts. Producers update only the
+	// depth and eviction counters; everything else is written by the worker thread. snapshot() may be called
+	// from any thread.
+	struct queue_metrics final
+	{
+		using clock = std::chrono::steady_clock;
+		using time_point = clock::time_point;
+
+		inline static constexpr bool c_enabled = true;
+
+		template <typename T>
+		struct entry final
+		{
+			void execute() { m_workItem.execute(); }
+
+			T m_workItem;
+			time_point m_enqueued;
+		};
+
+		template <typename T>
+		static entry<T> make_entry(T&& workItem) { return { std::move(workItem), clock::now() }; }
+
+		template <typename T>
+		static T& work_item(entry<T>& entry) { return entry.m_workItem; }
+
+		void on_enqueue(std::size_t count = 1)
+		{
+			m_enqueued.fetch_add(count, std::memory_order_relaxed);
+			auto depth = m_depth.fetch_add(count, std::memory_order_relaxed) + count;
+			auto highWater = m_highWaterDepth.load(std::memory_order_relaxed);
+			while (depth > highWater && !m_highWaterDepth.compare_exchange_weak(highWater, depth, std::memory_order_relaxed))
+			{
+			}
+		}
+
+		// A bounded backend rejected an item that on_enqueue already counted.
+		void on_dropped()
+		{
+			m_enqueued.fetch_sub(1, std::memory_order_relaxed);
+			m_depth.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		// A bounded backend discarded count queued items to make room; they will never be dequeued.
+		void on_evicted(std::size_t count)
+		{
+			m_evicted.fetch_add(count, std::memory_order_relaxed);
+			m_depth.fetch_sub(count, std::memory_order_relaxed);
+		}
+
+		template <typename T>
+		void on_dequeue(entry<T> const& entry)
+		{
+			m_depth.fetch_sub(1, std::memory_order_relaxed);
+			record(m_queueLatency, clock::now() - entry.m_enqueued);
+		}
+
+		time_point start_execute() const { return clock::now(); }
+
+		// A batch is recorded as one execute-duration sample.
+		void on_executed(time_point start, std::size_t count = 1)
+		{
+			record(m_executeDuration, clock::now() - start);
+			m_executed.fetch_add(count, std::memory_order_relaxed);
+		}
+
+		void on_exception() { m_exceptions.fetch_add(1, std::memory_order_relaxed); }
+
+		queue_metrics_snapshot snapshot() const
+		{
+			queue_metrics_snapshot result;
+			result.m_depth = m_depth.load(std::memory_order_relaxed);
+			result.m_highWaterDepth = m_highWaterDepth.load(std::memory_order_relaxed);
+			result.m_enqueued = m_enqueued.load(std::memory_order_relaxed);
+			result.m_executed = m_executed.load(std::memory_order_relaxed);
+			result.m_evicted = m_evicted.load(std::memory_order_relaxed);
+			result.m_exceptions = m_exceptions.load(std::memory_order_relaxed);
+			for (std::size_t bucket = 0; bucket < latency_histogram_snapshot::c_bucketCount; ++bucket)
+			{
+				result.m_queueLatency.m_buckets[bucket] = m_queueLatency[bucket].load(std::memory_order_relaxed);
+				result.m_executeDuration.m_buckets[bucket] = m_executeDuration[bucket].load(std::memory_order_relaxed);
+			}
+			return result;
+		}
+
+		// Resets the high-water mark to the current depth, e.g. after each scrape.
+		void reset_high_water()
+		{
+			m_highWaterDepth.store(m_depth.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+
+	private:
+		using histogram = std::array<std::atomic<uint64_t>, latency_histogram_snapshot::c_bucketCount>;
+
+		static void record(histogram& buckets, clock::duration elapsed)
+		{
+			auto nanoseconds = static_cast<uint64_t>(std::max<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), 0));
+			auto bucket = std::min<std::size_t>(std::bit_width(nanoseconds), latency_histogram_snapshot::c_bucketCount - 1);
+
+			// Only the worker thread records, so a load and store is enough.
+			buckets[bucket].store(buckets[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+
+		std::atomic<uint64_t> m_depth{};
+		std::atomic<uint64_t> m_highWaterDepth{};
+		std::atomic<uint64_t> m_enqueued{};
+		std::atomic<uint64_t> m_executed{};
+		std::atomic<uint64_t> m_evicted{};
+		std::atomic<uint64_t> m_exceptions{};
+		histogram m_queueLatency{};
+		histogram m_executeDuration{};
+	};
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+// Standard C++ headers
+#include <ranges>
+#include <type_traits>
+#include <utility>
+
+namespace taz
+{
+	// Passes on an element of a range that was taken as R&&: moved when the range is an owning rvalue, e.g.
+	// std::move(vector), and left as-is otherwise, so lvalue containers and views over them are copied from.
+	// Call as forward_element<R>(std::forward<decltype(element)>(element)) inside for (auto&& element : range).
+	template<typename R, typename TElement>
+	constexpr decltype(auto) forward_element(TElement&& element) noexcept
+	{
+		if constexpr (std::is_lvalue_reference_v<R> || std::ranges::view<std::remove_cvref_t<R>>)
+			return std::forward<TElement>(element);
+		else
+			return std::move(element);
+	}
+}
@@ -0,0 +1,465 @@
+#pragma once
+
+// Standard C headers
+#include <errno.h>
+#include <stdio.h>
+
+// Standard C++ headers
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#if defined(_WIN32)
+// Standard C++ headers
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Windows headers
+#include <io.h>
+#include <fileapi.h>
+#include <ioapiset.h>
+#include <processthreadsapi.h>
+#else
+#include <limits.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace taz
+{
+	// Writes to a pipe or socket without ever blocking. Whatever the reader is not ready for is appended to a
+	// temporary file, later output queues up behind it so ordering is kept, and drain() replays the file as the
+	// reader catches up. finish() gives the reader a bounded time to take the rest and leaves whatever it
+	// didn't in the file. Not thread-safe: meant to be owned by a single consumer thread.
+	//
+	// The stream's handle is shared with any process that inherited it, so its mode is never changed. On POSIX
+	// sockets are sent to with MSG_DONTWAIT and pipes are polled before each write. Windows has no documented
+	// way to ask a pipe how much it will take, so there a helper thread makes the blocking WriteFile calls and
+	// a write is spilled whenever the helper is still busy with the previous one.
+	struct spill_writer final
+	{
+		using clock = std::chrono::steady_clock;
+
+		// Returns no writer for streams that can't stall, such as regular files, terminals and Windows consoles
+		// (which take UTF-16); write those directly.
+		static std::unique_ptr<spill_writer> create(FILE* stream)
+		{
+#if defined(_WIN32)
+			auto handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(stream)));
+			if (handle == INVALID_HANDLE_VALUE || GetFileType(handle) != FILE_TYPE_PIPE)
+				return nullptr;
+
+			try
+			{
+				return std::unique_ptr<spill_writer>{ new spill_writer{ handle } };
+			}
+			catch (std::system_error const&)
+			{
+				// No helper thread, so nothing could be written without blocking.
+				return nullptr;
+			}
+#else
+			struct stat status{};
+			auto descriptor = fileno(stream);
+			if (descriptor < 0 || fstat(descriptor, &status) != 0 || !(S_ISFIFO(status.st_mode) || S_ISSOCK(status.st_mode)))
+				return nullptr;
+
+			return std::unique_ptr<spill_writer>{ new spill_writer{ descriptor, S_ISSOCK(status.st_mode) } };
+#endif
+		}
+
+		~spill_writer()
+		{
+			finish(std::chrono::milliseconds::zero());
+#if defined(_WIN32)
+			{
+				std::lock_guard lock{ m_lock };
+				m_stopping = true;
+			}
+			m_changed.notify_all();
+			m_helper.join();
+#endif
+		}
+
+		spill_writer(spill_writer const&) = delete;
+		spill_writer(spill_writer&&) = delete;
+		spill_writer& operator=(spill_writer const&) = delete;
+		spill_writer& operator=(spill_writer&&) = delete;
+
+		void write(std::string_view text)
+		{
+			if (m_failed)
+			{
+				write_blocking(text);
+				return;
+			}
+
+			if (m_spill)
+			{
+				spill(text);
+				drain();
+				return;
+			}
+
+			auto accepted = try_write(text);
+			if (accepted < text.size())
+			{
+				spill(text.substr(accepted));
+			}
+		}
+
+		// Replays as much of the spill file as the reader will take. Returns true once nothing is spilled, at
+		// which point the file is removed.
+		bool drain()
+		{
+			if (!m_spill)
+				return true;
+
+			std::array<char, 16 * 1024> buffer;
+			while (m_readOffset < m_spilledBytes)
+			{
+				auto wanted = static_cast<std::size_t>(std::min<uint64_t>(buffer.size(), m_spilledBytes - m_readOffset));
+				auto read = seek(m_readOffset) ? fread(buffer.data(), 1, wanted, m_spill) : 0;
+				if (read == 0)
+				{
+					m_readFailed = true;
+					return false;
+				}
+
+				auto accepted = try_write({ buffer.data(), read });
+				m_readOffset += accepted;
+				if (accepted < read)
+					return false;
+			}
+
+			close_spill(false);
+			return true;
+		}
+
+		// Gives the reader until timeout to take everything spilled. Returns true if it did; otherwise the
+		// output it never received, and only that, is left in spill_path() for the caller to report. The writer
+		// must not be written to afterwards.
+		bool finish(std::chrono::milliseconds timeout)
+		{
+			if (m_finished)
+				return m_path.empty();
+
+			m_finished = true;
+			auto deadline = clock::now() + timeout;
+			while (!drain() && !m_readFailed && wait_writable(deadline))
+			{
+			}
+
+#if defined(_WIN32)
+			auto unsentInFlight = settle(deadline);
+#else
+			std::string unsentInFlight;
+#endif
+			if (m_spill || !unsentInFlight.empty())
+				keep_unsent(unsentInFlight);
+			return m_path.empty();
+		}
+
+		bool pending() const { return m_spill != nullptr; }
+		// True once the spill file could not be written; from then on writes wait for the reader.
+		bool failed() const { return m_failed; }
+		std::filesystem::path const& spill_path() const { return m_path; }
+
+	private:
+#if defined(_WIN32)
+		explicit spill_writer(HANDLE handle)
+			: m_handle(handle)
+			, m_helper([this] { run_helper(); })
+		{
+		}
+
+		// Makes the blocking writes. A reader that has gone away fails the write, and the rest of the chunk is
+		// dropped: there is nowhere left to send it.
+		void run_helper()
+		{
+			std::unique_lock lock{ m_lock };
+			for (;;)
+			{
+				m_changed.wait(lock, [&] { return m_busy || m_stopping; });
+				if (!m_busy)
+					return;
+
+				lock.unlock();
+				std::size_t sent{};
+				DWORD error{};
+				while (sent < m_inFlight.size())
+				{
+					DWORD written{};
+					auto chunk = static_cast<DWORD>(std::min<std::size_t>(m_inFlight.size() - sent, 1u << 30));
+					auto succeeded = WriteFile(m_handle, m_inFlight.data() + sent, chunk, &written, nullptr);
+					sent += written;
+					if (!succeeded)
+					{
+						error = GetLastError();
+						break;
+					}
+				}
+				lock.lock();
+
+				// Only a write cancelled by settle() leaves anything to keep.
+				m_inFlightSent = error == ERROR_OPERATION_ABORTED ? sent : m_inFlight.size();
+				m_busy = false;
+				m_changed.notify_all();
+			}
+		}
+
+		// Waits until deadline for the helper to finish its chunk, then cancels the write if it hasn't and
+		// returns what it never sent.
+		std::string settle(clock::time_point deadline)
+		{
+			std::unique_lock lock{ m_lock };
+			m_changed.wait_until(lock, deadline, [&] { return !m_busy; });
+
+			// The helper may not have entered WriteFile yet when a cancel is issued, so keep cancelling.
+			while (m_busy)
+			{
+				CancelSynchronousIo(m_helper.native_handle());
+				m_changed.wait_for(lock, std::chrono::milliseconds{ 10 }, [&] { return !m_busy; });
+			}
+			return m_inFlight.substr(m_inFlightSent);
+		}
+#else
+		spill_writer(int descriptor, bool socket)
+			: m_descriptor(descriptor)
+			, m_socket(socket)
+		{
+		}
+#endif
+
+		// Returns how much of text was taken without blocking. Text that fails for any other reason, e.g. a
+		// reader that has gone away, counts as taken: there is nowhere left to send it.
+		std::size_t try_write(std::string_view text)
+		{
+#if defined(_WIN32)
+			// The helper takes a whole chunk at a time, and only when it has finished the last one.
+			std::lock_guard lock{ m_lock };
+			if (m_busy || text.empty())
+				return 0;
+
+			m_inFlight.assign(text);
+			m_inFlightSent = 0;
+			m_busy = true;
+			m_changed.notify_all();
+			return text.size();
+#else
+			std::size_t accepted{};
+			while (accepted < text.size())
+			{
+				ssize_t written{};
+				if (m_socket)
+				{
+					written = ::send(m_descriptor, text.data() + accepted, text.size() - accepted, MSG_DONTWAIT);
+				}
+				else
+				{
+					// A pipe that polls writable has room for PIPE_BUF bytes, and a write of at most PIPE_BUF
+					// is then taken whole, so the write below cannot block.
+					pollfd target{ m_descriptor, POLLOUT, 0 };
+					auto ready = ::poll(&target, 1, 0);
+					if (ready < 0 && errno == EINTR)
+						continue;
+					if (ready == 0)
+						break;
+					if (ready < 0 || (target.revents & (POLLERR | POLLNVAL)))
+						return text.size();
+
+					written = ::write(m_descriptor, text.data() + accepted, std::min<std::size_t>(text.size() - accepted, PIPE_BUF));
+				}
+
+				if (written < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					if (errno == EAGAIN || errno == EWOULDBLOCK)
+						break;
+					return text.size();
+				}
+				accepted += static_cast<std::size_t>(written);
+			}
+			return accepted;
+#endif
+		}
+
+		// Blocks until the reader can take more or deadline passes. Returns false when waiting can't help.
+		bool wait_writable(clock::time_point deadline)
+		{
+#if defined(_WIN32)
+			std::unique_lock lock{ m_lock };
+			if (deadline == clock::time_point::max())
+			{
+				m_changed.wait(lock, [&] { return !m_busy; });
+				return true;
+			}
+			return m_changed.wait_until(lock, deadline, [&] { return !m_busy; });
+#else
+			for (;;)
+			{
+				int timeout = -1;
+				if (deadline != clock::time_point::max())
+				{
+					auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - clock::now()).count();
+					timeout = static_cast<int>(std::clamp<std::chrono::milliseconds::rep>(remaining, 0, INT_MAX));
+				}
+
+				pollfd target{ m_descriptor, POLLOUT, 0 };
+				auto ready = ::poll(&target, 1, timeout);
+				if (ready < 0 && errno == EINTR)
+					continue;
+				return ready > 0 && !(target.revents & (POLLERR | POLLNVAL));
+			}
+#endif
+		}
+
+		void write_blocking(std::string_view text)
+		{
+			for (auto accepted = try_write(text); accepted < text.size() && wait_writable(clock::time_point::max()); accepted += try_write(text.substr(accepted)))
+			{
+			}
+		}
+
+		// Without a spill file the only way not to lose text is to wait for the reader after all, so that is
+		// what every write does from then on.
+		void spill(std::string_view text)
+		{
+			if (!m_failed && (m_spill || open_spill()) && fseek(m_spill, 0, SEEK_END) == 0)
+			{
+				auto written = fwrite(text.data(), 1, text.size(), m_spill);
+				m_spilledBytes += written;
+				text.remove_prefix(written);
+				if (text.empty())
+					return;
+			}
+
+			m_failed = true;
+			while (!drain() && !m_readFailed && wait_writable(clock::time_point::max()))
+			{
+			}
+			if (m_spill)
+				keep_unsent({});
+			write_blocking(text);
+		}
+
+		bool open_spill()
+		{
+			static std::atomic<uint32_t> s_sequence{};
+
+			std::error_code error;
+			auto directory = std::filesystem::temp_directory_path(error);
+			if (error)
+				return false;
+
+#if defined(_WIN32)
+			auto processId = GetCurrentProcessId();
+#else
+			auto processId = getpid();
+#endif
+			m_path = directory / ("taz-console-" + std::to_string(processId) + "-" + std::to_string(s_sequence++) + ".spill");
+
+#if defined(_WIN32)
+			m_spill = _wfopen(m_path.c_str(), L"w+b");
+#else
+			m_spill = fopen(m_path.c_str(), "w+b");
+#endif
+			if (!m_spill)
+				m_path.clear();
+			return m_spill != nullptr;
+		}
+
+		void close_spill(bool keep)
+		{
+			fclose(m_spill);
+			m_spill = nullptr;
+			m_readOffset = m_spilledBytes = 0;
+			if (!keep)
+			{
+				std::error_code error;
+				std::filesystem::remove(m_path, error);
+				m_path.clear();
+			}
+		}
+
+		// Rewrites the spill file so that it holds only what the reader never received: first, unsent text
+		// that had already left the file, then the part of the file that was never replayed.
+		void keep_unsent(std::string_view first)
+		{
+			if (!m_spill)
+			{
+				if (!open_spill())
+					return;
+				m_readOffset = m_spilledBytes;
+			}
+
+			auto unsent = m_path;
+			unsent += ".unsent";
+#if defined(_WIN32)
+			auto output = _wfopen(unsent.c_str(), L"wb");
+#else
+			auto output = fopen(unsent.c_str(), "wb");
+#endif
+			if (output)
+			{
+				fwrite(first.data(), 1, first.size(), output);
+
+				std::array<char, 16 * 1024> buffer;
+				for (std::size_t read{}; seek(m_readOffset) && (read = fread(buffer.data(), 1, buffer.size(), m_spill)) != 0; m_readOffset += read)
+				{
+					fwrite(buffer.data(), 1, read, output);
+				}
+				fclose(output);
+			}
+			close_spill(true);
+
+			if (output)
+			{
+				std::error_code error;
+				std::filesystem::rename(unsent, m_path, error);
+			}
+		}
+
+		bool seek(uint64_t offset)
+		{
+#if defined(_WIN32)
+			return _fseeki64(m_spill, static_cast<int64_t>(offset), SEEK_SET) == 0;
+#else
+			return fseeko(m_spill, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+		}
+
+#if defined(_WIN32)
+		HANDLE m_handle{};
+		std::mutex m_lock{};
+		std::condition_variable m_changed{};
+		std::string m_inFlight{};
+		std::size_t m_inFlightSent{};
+		bool m_busy{};
+		bool m_stopping{};
+		std::thread m_helper;
+#else
+		int m_descriptor{ -1 };
+		bool m_socket{};
+#endif
+		bool m_finished{};
+		bool m_failed{};
+		bool m_readFailed{};
+		FILE* m_spill{};
+		std::filesystem::path m_path{};
+		uint64_t m_readOffset{};
+		uint64_t m_spilledBytes{};
+	};
+}
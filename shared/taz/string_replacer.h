@@ -0,0 +1,245 @@
+#pragma once
+
+// Standard C++ headers
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace taz::string_utility
+{
+	// Multi-pattern replacer compiled once into an Aho-Corasick automaton and reused across calls. Unlike
+	// replace_all, which applies each pair to the output of the previous one, every pattern is matched against
+	// the original text at once: the leftmost match wins, the longest pattern wins among matches starting at
+	// the same position, and replaced text is never rescanned. The text is read once and written once into
+	// a fresh buffer, so the cost is linear in the input plus the number of matches.
+	template <typename CharT>
+	struct basic_replacer final
+	{
+		using view_type = std::basic_string_view<CharT>;
+		using string_type = std::basic_string<CharT>;
+		using replacement_list = std::vector<std::pair<view_type, view_type>>;
+
+		// Empty patterns are ignored; if a pattern is listed twice the first replacement is used.
+		explicit basic_replacer(replacement_list const& replacements)
+		{
+			m_states.emplace_back();
+			for (auto const& [from, to] : replacements)
+			{
+				if (from.empty())
+					continue;
+
+				auto state = insert(from);
+				if (m_states[state].m_pattern != c_noPattern)
+					continue;
+
+				m_states[state].m_pattern = static_cast<uint32_t>(m_patterns.size());
+				m_patterns.push_back({ from.size(), m_replacementText.size(), to.size() });
+				m_replacementText.append(to);
+				m_maxLength = std::max(m_maxLength, from.size());
+			}
+
+			build_links();
+		}
+
+		~basic_replacer() = default;
+		basic_replacer(basic_replacer const&) = default;
+		basic_replacer(basic_replacer&&) = default;
+		basic_replacer& operator=(basic_replacer const&) = default;
+		basic_replacer& operator=(basic_replacer&&) = default;
+
+		string_type replace_all(view_type text) const
+		{
+			string_type result;
+			result.reserve(text.size());
+			replace_all(text, result);
+			return result;
+		}
+
+		// Appends the rewritten text to output. Safe to call from several threads at once.
+		void replace_all(view_type text, string_type& output) const
+		{
+			std::size_t literalStart{};
+			for_each_match(text, 0, text.size(), [&](std::size_t start, uint32_t patternIndex)
+			{
+				output.append(text.substr(literalStart, start - literalStart));
+				output.append(replacement(patternIndex));
+				literalStart = start + pattern_length(patternIndex);
+			});
+			output.append(text.substr(literalStart));
+		}
+
+		// Runs the greedy match from position from, as if the text began there, calling onMatch(start, pattern)
+		// for each match in order. Stops at the first position at or after limit that is not inside a match,
+		// and returns it; text past limit is only read to finish matches that started before it.
+		template <typename OnMatch>
+		std::size_t for_each_match(view_type text, std::size_t from, std::size_t limit, OnMatch&& onMatch) const
+		{
+			if (m_patterns.empty())
+				return limit;
+
+			// Longest match starting at each of the last m_maxLength positions. A start is only final once the
+			// scan is m_maxLength - 1 past it, so a ring of that size is all the lookahead the greedy pass needs.
+			std::vector<candidate> candidates(m_maxLength);
+			auto cursor = from;
+
+			auto settle = [&](std::size_t settled)
+			{
+				while (cursor < settled && cursor < limit)
+				{
+					auto const& best = candidates[cursor % m_maxLength];
+					if (best.m_start != cursor)
+					{
+						++cursor;
+						continue;
+					}
+
+					onMatch(cursor, best.m_pattern);
+					cursor += m_patterns[best.m_pattern].m_length;
+				}
+			};
+
+			uint32_t state{};
+			for (auto position = from; position < text.size() && cursor < limit; ++position)
+			{
+				state = step(state, text[position]);
+
+				// Walk every pattern ending here, longest first.
+				auto match = m_states[state].m_pattern != c_noPattern ? state : m_states[state].m_dictionary;
+				for (; match != 0; match = m_states[match].m_dictionary)
+				{
+					auto patternIndex = m_states[match].m_pattern;
+					auto start = position + 1 - m_patterns[patternIndex].m_length;
+					if (start < cursor)
+						continue;
+
+					auto& best = candidates[start % m_maxLength];
+					if (best.m_start != start || m_patterns[best.m_pattern].m_length < m_patterns[patternIndex].m_length)
+						best = { start, patternIndex };
+				}
+
+				if (position + 1 >= m_maxLength)
+					settle(position + 2 - m_maxLength);
+			}
+
+			settle(text.size());
+			return cursor;
+		}
+
+		std::size_t pattern_length(uint32_t patternIndex) const { return m_patterns[patternIndex].m_length; }
+
+		view_type replacement(uint32_t patternIndex) const
+		{
+			auto const& pattern = m_patterns[patternIndex];
+			return view_type{ m_replacementText }.substr(pattern.m_replacementOffset, pattern.m_replacementLength);
+		}
+
+		bool empty() const { return m_patterns.empty(); }
+		std::size_t max_pattern_length() const { return m_maxLength; }
+
+	private:
+		inline static constexpr uint32_t c_noPattern = std::numeric_limits<uint32_t>::max();
+
+		struct edge final
+		{
+			CharT m_character;
+			uint32_t m_target;
+		};
+
+		struct state final
+		{
+			std::vector<edge> m_edges{};  // Sorted by character.
+			uint32_t m_failure{};
+			uint32_t m_dictionary{};      // Nearest state on the failure chain that ends a pattern, or 0.
+			uint32_t m_pattern{ c_noPattern };
+		};
+
+		struct pattern final
+		{
+			std::size_t m_length;
+			std::size_t m_replacementOffset;
+			std::size_t m_replacementLength;
+		};
+
+		struct candidate final
+		{
+			std::size_t m_start{ std::numeric_limits<std::size_t>::max() };
+			uint32_t m_pattern{};
+		};
+
+		// Returns the child of state for character, or 0 (the root is nobody's child).
+		uint32_t child(uint32_t state, CharT character) const
+		{
+			auto const& edges = m_states[state].m_edges;
+			auto found = std::lower_bound(edges.begin(), edges.end(), character,
+				[](edge const& edge, CharT value) { return edge.m_character < value; });
+			return (found != edges.end() && found->m_character == character) ? found->m_target : 0;
+		}
+
+		uint32_t step(uint32_t state, CharT character) const
+		{
+			for (;;)
+			{
+				if (auto next = child(state, character))
+					return next;
+				if (state == 0)
+					return 0;
+				state = m_states[state].m_failure;
+			}
+		}
+
+		uint32_t insert(view_type pattern)
+		{
+			uint32_t state{};
+			for (auto character : pattern)
+			{
+				auto next = child(state, character);
+				if (next == 0)
+				{
+					next = static_cast<uint32_t>(m_states.size());
+					auto& edges = m_states[state].m_edges;
+					auto position = std::lower_bound(edges.begin(), edges.end(), character,
+						[](edge const& edge, CharT value) { return edge.m_character < value; });
+					edges.insert(position, { character, next });
+					m_states.emplace_back();
+				}
+				state = next;
+			}
+			return state;
+		}
+
+		void build_links()
+		{
+			// Breadth-first, so every failure target is finished before the states that point at it.
+			std::vector<uint32_t> order;
+			order.reserve(m_states.size());
+			for (auto const& edge : m_states[0].m_edges)
+				order.push_back(edge.m_target);
+
+			for (std::size_t index = 0; index < order.size(); ++index)
+			{
+				auto parent = order[index];
+				for (auto const& edge : m_states[parent].m_edges)
+				{
+					auto failure = step(m_states[parent].m_failure, edge.m_character);
+					auto& target = m_states[edge.m_target];
+					target.m_failure = failure;
+					target.m_dictionary = m_states[failure].m_pattern != c_noPattern ? failure : m_states[failure].m_dictionary;
+					order.push_back(edge.m_target);
+				}
+			}
+		}
+
+		std::vector<state> m_states{};
+		std::vector<pattern> m_patterns{};
+		string_type m_replacementText{};
+		std::size_t m_maxLength{};
+	};
+
+	using replacer = basic_replacer<char>;
+	using wreplacer = basic_replacer<wchar_t>;
+}
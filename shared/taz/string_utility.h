@@ -1,45 +1,52 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ranges>
+#include <span>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <vector>
 
+#include "utf.h"
+
 namespace taz::string_utility
 {
+	// Both directions convert in one pass into a worst-case sized buffer, then trim it. Invalid input is replaced
+	// with U+FFFD exactly as CP_UTF8 conversions with no flags do.
 	inline std::string narrow(std::wstring_view wideText)
 	{
-		int32_t byteCount = ::WideCharToMultiByte(CP_UTF8, 0,
-			wideText.data(), static_cast<int32_t>(wideText.length()),
-			nullptr, 0,
-			nullptr, nullptr);
-
-		std::string multibyteText(byteCount, '\0');
-		::WideCharToMultiByte(CP_UTF8, 0,
-			wideText.data(), static_cast<int32_t>(wideText.length()),
-			multibyteText.data(), static_cast<int32_t>(multibyteText.length()),
-			nullptr, nullptr);
+		std::string multibyteText(utf::max_utf8_length<wchar_t>(wideText.length()), '\0');
+		auto result = utf::wide_to_utf8(wideText, std::span{ multibyteText });
+		multibyteText.resize(result.m_written);
 
 		return multibyteText;
 	}
 
 	inline std::wstring widen(std::string_view multibylteText)
 	{
-		int32_t byteCount = ::MultiByteToWideChar(CP_UTF8, 0,
-			multibylteText.data(), static_cast<int32_t>(multibylteText.length()),
-			nullptr, 0);
-
-		std::wstring wideText(byteCount, L'\0');
-		::MultiByteToWideChar(CP_UTF8, 0,
-			multibylteText.data(), static_cast<int32_t>(multibylteText.length()),
-			wideText.data(), static_cast<int32_t>(wideText.length()));
+		std::wstring wideText(utf::max_wide_length(multibylteText.length()), L'\0');
+		auto result = utf::utf8_to_wide(multibylteText, std::span{ wideText });
+		wideText.resize(result.m_written);
 
 		return wideText;
 	}
 
 	inline std::string narrow(wchar_t wideChar)
 	{
-		std::wstring wideText(1, wideChar);
-		return narrow(std::wstring_view(wideText));
+		return narrow(std::wstring_view(&wideChar, 1));
 	}
 
 	inline std::wstring widen(char multibyteChar)
@@ -47,13 +54,230 @@ namespace taz::string_utility
 		return widen(std::string_view(&multibyteChar, 1));
 	}
 
+	// Fixed-capacity, null-terminated string stored inline, for converting on the stack without allocating.
+	template <typename CharT, std::size_t Capacity>
+	struct inplace_basic_string final
+	{
+		using value_type = CharT;
+
+		CharT* data() { return m_data.data(); }
+		CharT const* data() const { return m_data.data(); }
+		CharT const* c_str() const { return m_data.data(); }
+		std::size_t size() const { return m_size; }
+		static constexpr std::size_t capacity() { return Capacity; }
+		bool empty() const { return m_size == 0; }
+
+		void clear()
+		{
+			m_size = 0;
+			m_data[0] = CharT{};
+		}
+
+		std::basic_string_view<CharT> view() const { return { m_data.data(), m_size }; }
+		operator std::basic_string_view<CharT>() const { return view(); }
+
+		// The unused tail, and the call that claims the part of it that was written.
+		std::span<CharT> spare() { return { m_data.data() + m_size, Capacity - m_size }; }
+		void commit(std::size_t count)
+		{
+			m_size += count;
+			m_data[m_size] = CharT{};
+		}
+
+	private:
+		std::array<CharT, Capacity + 1> m_data{};
+		std::size_t m_size{};
+	};
+
+	template <std::size_t Capacity>
+	using inplace_string = inplace_basic_string<char, Capacity>;
+
+	template <std::size_t Capacity>
+	using inplace_wstring = inplace_basic_string<wchar_t, Capacity>;
+
+	// Non-allocating conversions. Each converts as much as fits and reports how many units were read and
+	// written; m_status is output_too_small when the output filled up first, in which case the output ends on a
+	// whole code point and the call can be repeated with the unread remainder.
+	inline utf::conversion_result narrow(std::wstring_view wideText, std::span<char> output)
+	{
+		return utf::wide_to_utf8(wideText, output);
+	}
+
+	inline utf::conversion_result widen(std::string_view multibyteText, std::span<wchar_t> output)
+	{
+		return utf::utf8_to_wide(multibyteText, output);
+	}
+
+	template <std::size_t Capacity>
+	utf::conversion_result narrow_append(std::wstring_view wideText, inplace_string<Capacity>& output)
+	{
+		auto result = utf::wide_to_utf8(wideText, output.spare());
+		output.commit(result.m_written);
+		return result;
+	}
+
+	template <std::size_t Capacity>
+	utf::conversion_result widen_append(std::string_view multibyteText, inplace_wstring<Capacity>& output)
+	{
+		auto result = utf::utf8_to_wide(multibyteText, output.spare());
+		output.commit(result.m_written);
+		return result;
+	}
+
+	// Appends the whole conversion. Existing capacity is reused when it covers the worst case; otherwise the
+	// exact length is measured first so the string grows once, to the size it needs.
+	inline utf::conversion_result narrow_append(std::wstring_view wideText, std::string& output)
+	{
+		auto const existing = output.size();
+		auto needed = utf::max_utf8_length<wchar_t>(wideText.length());
+		if (needed > output.capacity() - existing)
+			needed = utf::utf8_length(wideText);
+
+		output.resize(existing + needed);
+		auto result = utf::wide_to_utf8(wideText, std::span{ output }.subspan(existing));
+		output.resize(existing + result.m_written);
+		return result;
+	}
+
+	inline utf::conversion_result widen_append(std::string_view multibyteText, std::wstring& output)
+	{
+		auto const existing = output.size();
+		auto needed = utf::max_wide_length(multibyteText.length());
+		if (needed > output.capacity() - existing)
+			needed = utf::wide_length<wchar_t>(multibyteText);
+
+		output.resize(existing + needed);
+		auto result = utf::utf8_to_wide(multibyteText, std::span{ output }.subspan(existing));
+		output.resize(existing + result.m_written);
+		return result;
+	}
+
+	// Transcodes a stream that arrives in arbitrary chunks, e.g. from a pipe or socket. A code point split
+	// across chunks is held back (at most 3 bytes, or one surrogate) and completed by the next write, so chunk
+	// boundaries never produce replacement characters. Output is produced through a fixed stack buffer, so
+	// memory use does not depend on the length of the stream. Call finish() at the end of the stream.
+	template <typename InputChar, typename OutputChar>
+	struct basic_stream_transcoder final
+	{
+		using input_view = std::basic_string_view<InputChar>;
+		using output_view = std::basic_string_view<OutputChar>;
+
+		// Converts chunk, calling sink with each piece of output as it is produced.
+		template <std::invocable<output_view> Sink>
+		void write(input_view chunk, Sink&& sink)
+		{
+			inplace_basic_string<OutputChar, c_bufferSize> buffer;
+
+			if (m_pendingSize != 0)
+			{
+				// Complete the held-back sequence from the front of this chunk.
+				std::array<InputChar, c_pendingCapacity> joined{};
+				auto const pendingSize = m_pendingSize;
+				auto const taken = std::min(c_pendingCapacity - pendingSize, chunk.size());
+				std::copy_n(m_pending.begin(), pendingSize, joined.begin());
+				std::copy_n(chunk.begin(), taken, joined.begin() + pendingSize);
+
+				auto result = convert(input_view{ joined.data(), pendingSize + taken }, buffer, false);
+				if (result.m_read == 0)
+				{
+					// Still incomplete; the whole chunk was too short to finish it.
+					m_pending = joined;
+					m_pendingSize = pendingSize + taken;
+					return;
+				}
+
+				// The held-back units are always consumed together, so the rest of the joined buffer maps onto chunk.
+				m_pendingSize = 0;
+				chunk.remove_prefix(result.m_read - pendingSize);
+				if (!buffer.empty())
+					sink(buffer.view());
+			}
+
+			while (!chunk.empty())
+			{
+				buffer.clear();
+				auto result = convert(chunk, buffer, false);
+				chunk.remove_prefix(result.m_read);
+				if (!buffer.empty())
+					sink(buffer.view());
+
+				if (result.m_status == utf::conversion_status::incomplete_input)
+				{
+					std::copy(chunk.begin(), chunk.end(), m_pending.begin());
+					m_pendingSize = chunk.size();
+					break;
+				}
+			}
+		}
+
+		void write(input_view chunk, std::basic_string<OutputChar>& output)
+		{
+			write(chunk, [&](output_view piece) { output.append(piece); });
+		}
+
+		// Ends the stream. A sequence still held back is truncated and becomes U+FFFD.
+		template <std::invocable<output_view> Sink>
+		void finish(Sink&& sink)
+		{
+			if (m_pendingSize == 0)
+				return;
+
+			inplace_basic_string<OutputChar, c_bufferSize> buffer;
+			convert(input_view{ m_pending.data(), m_pendingSize }, buffer, true);
+			m_pendingSize = 0;
+			sink(buffer.view());
+		}
+
+		void finish(std::basic_string<OutputChar>& output)
+		{
+			finish([&](output_view piece) { output.append(piece); });
+		}
+
+		// Discards anything held back, e.g. after the source reconnects.
+		void reset()
+		{
+			m_pendingSize = 0;
+			m_replacements = 0;
+		}
+
+		bool has_pending() const { return m_pendingSize != 0; }
+
+		// Ill-formed sequences replaced so far; zero means the stream has been valid.
+		std::size_t replacements() const { return m_replacements; }
+
+	private:
+		inline static constexpr std::size_t c_pendingCapacity = sizeof(InputChar) == 1 ? 4 : 2;
+		inline static constexpr std::size_t c_bufferSize = 512;
+
+		utf::conversion_result convert(input_view input, inplace_basic_string<OutputChar, c_bufferSize>& buffer, bool endOfInput)
+		{
+			utf::conversion_result result;
+			if constexpr (sizeof(InputChar) == 1)
+				result = utf::utf8_to_wide(input, buffer.spare(), endOfInput);
+			else
+				result = utf::wide_to_utf8(input, buffer.spare(), endOfInput);
+
+			buffer.commit(result.m_written);
+			m_replacements += result.m_replacements;
+			return result;
+		}
+
+		std::array<InputChar, c_pendingCapacity> m_pending{};
+		std::size_t m_pendingSize{};
+		std::size_t m_replacements{};
+	};
+
+	using widen_stream = basic_stream_transcoder<char, wchar_t>;
+	using narrow_stream = basic_stream_transcoder<wchar_t, char>;
+
 	template <typename _Elem, typename _Traits = std::char_traits<_Elem>, typename _Alloc = std::allocator<_Elem>>
 	std::basic_string<_Elem, _Traits, _Alloc>
 		replace_all(
 			std::basic_string_view<_Elem> text,
 			const std::vector<std::pair<std::basic_string_view<_Elem>, std::basic_string_view<_Elem>>>& replacements)
 	{
-		// Note that this could be optimized to not modify in-place
+		// Applies each pair in turn to the output of the previous one. For large texts, or when the pairs should be
+		// matched simultaneously, build a basic_replacer (string_replacer.h) once and reuse it.
 		std::basic_string<_Elem, _Traits, _Alloc> result(text);
 
 		for (const auto& [from, to] : replacements)
@@ -63,7 +287,7 @@ namespace taz::string_utility
 				if (found = result.find(from, position); found != std::string::npos)
 				{
 					result.replace(result.begin() + found, result.begin() + found + from.length(), to);
-					position += to.size();
+					position = found + to.size();
 				}
 			}
 		}
@@ -80,18 +304,694 @@ namespace taz::string_utility
 		return replace_all(std::basic_string_view<_Elem>(text), replacements);
 	}
 
+	namespace details
+	{
+		// A run of BMP code units from m_first to m_last, every m_stride-th of which upper-cases to itself plus
+		// m_delta. Sorted by m_first; the runs never overlap.
+		struct fold_range final
+		{
+			char16_t m_first;
+			char16_t m_last;
+			int32_t m_delta;
+			uint8_t m_stride;
+		};
+
+		// The Unicode 14.0 simple (one to one) upper-case mappings of U+0080..U+FFFF.
+		inline constexpr fold_range c_foldRanges[]
+		{
+			{ 0x00B5, 0x00B5, 743, 1 }, { 0x00E0, 0x00F6, -32, 1 }, { 0x00F8, 0x00FE, -32, 1 },
+			{ 0x00FF, 0x00FF, 121, 1 }, { 0x0101, 0x012F, -1, 2 }, { 0x0131, 0x0131, -232, 1 },
+			{ 0x0133, 0x0137, -1, 2 }, { 0x013A, 0x0148, -1, 2 }, { 0x014B, 0x0177, -1, 2 }, { 0x017A, 0x017E, -1, 2 },
+			{ 0x017F, 0x017F, -300, 1 }, { 0x0180, 0x0180, 195, 1 }, { 0x0183, 0x0185, -1, 2 },
+			{ 0x0188, 0x0188, -1, 1 }, { 0x018C, 0x018C, -1, 1 }, { 0x0192, 0x0192, -1, 1 }, { 0x0195, 0x0195, 97, 1 },
+			{ 0x0199, 0x0199, -1, 1 }, { 0x019A, 0x019A, 163, 1 }, { 0x019E, 0x019E, 130, 1 },
+			{ 0x01A1, 0x01A5, -1, 2 }, { 0x01A8, 0x01A8, -1, 1 }, { 0x01AD, 0x01AD, -1, 1 }, { 0x01B0, 0x01B0, -1, 1 },
+			{ 0x01B4, 0x01B6, -1, 2 }, { 0x01B9, 0x01B9, -1, 1 }, { 0x01BD, 0x01BD, -1, 1 }, { 0x01BF, 0x01BF, 56, 1 },
+			{ 0x01C5, 0x01C5, -1, 1 }, { 0x01C6, 0x01C6, -2, 1 }, { 0x01C8, 0x01C8, -1, 1 }, { 0x01C9, 0x01C9, -2, 1 },
+			{ 0x01CB, 0x01CB, -1, 1 }, { 0x01CC, 0x01CC, -2, 1 }, { 0x01CE, 0x01DC, -1, 2 },
+			{ 0x01DD, 0x01DD, -79, 1 }, { 0x01DF, 0x01EF, -1, 2 }, { 0x01F2, 0x01F2, -1, 1 },
+			{ 0x01F3, 0x01F3, -2, 1 }, { 0x01F5, 0x01F5, -1, 1 }, { 0x01F9, 0x021F, -1, 2 }, { 0x0223, 0x0233, -1, 2 },
+			{ 0x023C, 0x023C, -1, 1 }, { 0x023F, 0x0240, 10815, 1 }, { 0x0242, 0x0242, -1, 1 },
+			{ 0x0247, 0x024F, -1, 2 }, { 0x0250, 0x0250, 10783, 1 }, { 0x0251, 0x0251, 10780, 1 },
+			{ 0x0252, 0x0252, 10782, 1 }, { 0x0253, 0x0253, -210, 1 }, { 0x0254, 0x0254, -206, 1 },
+			{ 0x0256, 0x0257, -205, 1 }, { 0x0259, 0x0259, -202, 1 }, { 0x025B, 0x025B, -203, 1 },
+			{ 0x025C, 0x025C, 42319, 1 }, { 0x0260, 0x0260, -205, 1 }, { 0x0261, 0x0261, 42315, 1 },
+			{ 0x0263, 0x0263, -207, 1 }, { 0x0265, 0x0265, 42280, 1 }, { 0x0266, 0x0266, 42308, 1 },
+			{ 0x0268, 0x0268, -209, 1 }, { 0x0269, 0x0269, -211, 1 }, { 0x026A, 0x026A, 42308, 1 },
+			{ 0x026B, 0x026B, 10743, 1 }, { 0x026C, 0x026C, 42305, 1 }, { 0x026F, 0x026F, -211, 1 },
+			{ 0x0271, 0x0271, 10749, 1 }, { 0x0272, 0x0272, -213, 1 }, { 0x0275, 0x0275, -214, 1 },
+			{ 0x027D, 0x027D, 10727, 1 }, { 0x0280, 0x0280, -218, 1 }, { 0x0282, 0x0282, 42307, 1 },
+			{ 0x0283, 0x0283, -218, 1 }, { 0x0287, 0x0287, 42282, 1 }, { 0x0288, 0x0288, -218, 1 },
+			{ 0x0289, 0x0289, -69, 1 }, { 0x028A, 0x028B, -217, 1 }, { 0x028C, 0x028C, -71, 1 },
+			{ 0x0292, 0x0292, -219, 1 }, { 0x029D, 0x029D, 42261, 1 }, { 0x029E, 0x029E, 42258, 1 },
+			{ 0x0345, 0x0345, 84, 1 }, { 0x0371, 0x0373, -1, 2 }, { 0x0377, 0x0377, -1, 1 },
+			{ 0x037B, 0x037D, 130, 1 }, { 0x03AC, 0x03AC, -38, 1 }, { 0x03AD, 0x03AF, -37, 1 },
+			{ 0x03B1, 0x03C1, -32, 1 }, { 0x03C2, 0x03C2, -31, 1 }, { 0x03C3, 0x03CB, -32, 1 },
+			{ 0x03CC, 0x03CC, -64, 1 }, { 0x03CD, 0x03CE, -63, 1 }, { 0x03D0, 0x03D0, -62, 1 },
+			{ 0x03D1, 0x03D1, -57, 1 }, { 0x03D5, 0x03D5, -47, 1 }, { 0x03D6, 0x03D6, -54, 1 },
+			{ 0x03D7, 0x03D7, -8, 1 }, { 0x03D9, 0x03EF, -1, 2 }, { 0x03F0, 0x03F0, -86, 1 },
+			{ 0x03F1, 0x03F1, -80, 1 }, { 0x03F2, 0x03F2, 7, 1 }, { 0x03F3, 0x03F3, -116, 1 },
+			{ 0x03F5, 0x03F5, -96, 1 }, { 0x03F8, 0x03F8, -1, 1 }, { 0x03FB, 0x03FB, -1, 1 },
+			{ 0x0430, 0x044F, -32, 1 }, { 0x0450, 0x045F, -80, 1 }, { 0x0461, 0x0481, -1, 2 },
+			{ 0x048B, 0x04BF, -1, 2 }, { 0x04C2, 0x04CE, -1, 2 }, { 0x04CF, 0x04CF, -15, 1 },
+			{ 0x04D1, 0x052F, -1, 2 }, { 0x0561, 0x0586, -48, 1 }, { 0x10D0, 0x10FA, 3008, 1 },
+			{ 0x10FD, 0x10FF, 3008, 1 }, { 0x13F8, 0x13FD, -8, 1 }, { 0x1C80, 0x1C80, -6254, 1 },
+			{ 0x1C81, 0x1C81, -6253, 1 }, { 0x1C82, 0x1C82, -6244, 1 }, { 0x1C83, 0x1C84, -6242, 1 },
+			{ 0x1C85, 0x1C85, -6243, 1 }, { 0x1C86, 0x1C86, -6236, 1 }, { 0x1C87, 0x1C87, -6181, 1 },
+			{ 0x1C88, 0x1C88, 35266, 1 }, { 0x1D79, 0x1D79, 35332, 1 }, { 0x1D7D, 0x1D7D, 3814, 1 },
+			{ 0x1D8E, 0x1D8E, 35384, 1 }, { 0x1E01, 0x1E95, -1, 2 }, { 0x1E9B, 0x1E9B, -59, 1 },
+			{ 0x1EA1, 0x1EFF, -1, 2 }, { 0x1F00, 0x1F07, 8, 1 }, { 0x1F10, 0x1F15, 8, 1 }, { 0x1F20, 0x1F27, 8, 1 },
+			{ 0x1F30, 0x1F37, 8, 1 }, { 0x1F40, 0x1F45, 8, 1 }, { 0x1F51, 0x1F57, 8, 2 }, { 0x1F60, 0x1F67, 8, 1 },
+			{ 0x1F70, 0x1F71, 74, 1 }, { 0x1F72, 0x1F75, 86, 1 }, { 0x1F76, 0x1F77, 100, 1 },
+			{ 0x1F78, 0x1F79, 128, 1 }, { 0x1F7A, 0x1F7B, 112, 1 }, { 0x1F7C, 0x1F7D, 126, 1 },
+			{ 0x1F80, 0x1F87, 8, 1 }, { 0x1F90, 0x1F97, 8, 1 }, { 0x1FA0, 0x1FA7, 8, 1 }, { 0x1FB0, 0x1FB1, 8, 1 },
+			{ 0x1FB3, 0x1FB3, 9, 1 }, { 0x1FBE, 0x1FBE, -7205, 1 }, { 0x1FC3, 0x1FC3, 9, 1 }, { 0x1FD0, 0x1FD1, 8, 1 },
+			{ 0x1FE0, 0x1FE1, 8, 1 }, { 0x1FE5, 0x1FE5, 7, 1 }, { 0x1FF3, 0x1FF3, 9, 1 }, { 0x214E, 0x214E, -28, 1 },
+			{ 0x2170, 0x217F, -16, 1 }, { 0x2184, 0x2184, -1, 1 }, { 0x24D0, 0x24E9, -26, 1 },
+			{ 0x2C30, 0x2C5F, -48, 1 }, { 0x2C61, 0x2C61, -1, 1 }, { 0x2C65, 0x2C65, -10795, 1 },
+			{ 0x2C66, 0x2C66, -10792, 1 }, { 0x2C68, 0x2C6C, -1, 2 }, { 0x2C73, 0x2C73, -1, 1 },
+			{ 0x2C76, 0x2C76, -1, 1 }, { 0x2C81, 0x2CE3, -1, 2 }, { 0x2CEC, 0x2CEE, -1, 2 }, { 0x2CF3, 0x2CF3, -1, 1 },
+			{ 0x2D00, 0x2D25, -7264, 1 }, { 0x2D27, 0x2D27, -7264, 1 }, { 0x2D2D, 0x2D2D, -7264, 1 },
+			{ 0xA641, 0xA66D, -1, 2 }, { 0xA681, 0xA69B, -1, 2 }, { 0xA723, 0xA72F, -1, 2 }, { 0xA733, 0xA76F, -1, 2 },
+			{ 0xA77A, 0xA77C, -1, 2 }, { 0xA77F, 0xA787, -1, 2 }, { 0xA78C, 0xA78C, -1, 1 }, { 0xA791, 0xA793, -1, 2 },
+			{ 0xA794, 0xA794, 48, 1 }, { 0xA797, 0xA7A9, -1, 2 }, { 0xA7B5, 0xA7C3, -1, 2 }, { 0xA7C8, 0xA7CA, -1, 2 },
+			{ 0xA7D1, 0xA7D1, -1, 1 }, { 0xA7D7, 0xA7D9, -1, 2 }, { 0xA7F6, 0xA7F6, -1, 1 },
+			{ 0xAB53, 0xAB53, -928, 1 }, { 0xAB70, 0xABBF, -38864, 1 }, { 0xFF41, 0xFF5A, -32, 1 },
+		};
+	}
+
+	// Ordinal case folding, as CompareStringOrdinal does with bIgnoreCase: each code unit is mapped to upper
+	// case on its own and the results are compared as numbers. The mapping is a fixed table, so it depends on
+	// neither the locale nor the platform; units outside the BMP, and surrogates, are left as they are.
+	inline wchar_t fold_case(wchar_t character)
+	{
+		if (character < 0x80)
+			return (character >= L'a' && character <= L'z') ? static_cast<wchar_t>(character - 0x20) : character;
+
+		auto unit = static_cast<std::make_unsigned_t<wchar_t>>(character);
+		if (unit > 0xFFFF)
+			return character;
+
+		auto found = std::upper_bound(std::begin(details::c_foldRanges), std::end(details::c_foldRanges), unit,
+			[](auto value, details::fold_range const& range) { return value < range.m_first; });
+		if (found == std::begin(details::c_foldRanges))
+			return character;
+
+		auto const& range = *--found;
+		if (unit > range.m_last || (unit - range.m_first) % range.m_stride != 0)
+			return character;
+		return static_cast<wchar_t>(static_cast<int32_t>(unit) + range.m_delta);
+	}
+
+	namespace details
+	{
+		inline constexpr std::size_t c_foldBlockSize = 8;
+
+		// Folds up to c_foldBlockSize units. A full block of ASCII, by far the common case, is folded with SSE2.
+		inline void fold_block(wchar_t const* input, std::size_t count, wchar_t* output)
+		{
+#if defined(TAZ_UTF_SSE2)
+			if (count == c_foldBlockSize)
+			{
+				auto source = reinterpret_cast<__m128i const*>(input);
+				auto target = reinterpret_cast<__m128i*>(output);
+				if constexpr (sizeof(wchar_t) == 2)
+				{
+					auto units = _mm_loadu_si128(source);
+					auto nonAscii = _mm_and_si128(units, _mm_set1_epi16(static_cast<short>(0xFF80)));
+					if (_mm_movemask_epi8(_mm_cmpeq_epi16(nonAscii, _mm_setzero_si128())) == 0xFFFF)
+					{
+						auto lower = _mm_and_si128(_mm_cmpgt_epi16(units, _mm_set1_epi16('a' - 1)), _mm_cmplt_epi16(units, _mm_set1_epi16('z' + 1)));
+						_mm_storeu_si128(target, _mm_sub_epi16(units, _mm_and_si128(lower, _mm_set1_epi16(0x20))));
+						return;
+					}
+				}
+				else
+				{
+					auto first = _mm_loadu_si128(source);
+					auto second = _mm_loadu_si128(source + 1);
+					auto nonAscii = _mm_and_si128(_mm_or_si128(first, second), _mm_set1_epi32(static_cast<int>(0xFFFFFF80)));
+					if (_mm_movemask_epi8(_mm_cmpeq_epi32(nonAscii, _mm_setzero_si128())) == 0xFFFF)
+					{
+						auto fold = [](__m128i units)
+						{
+							auto lower = _mm_and_si128(_mm_cmpgt_epi32(units, _mm_set1_epi32('a' - 1)), _mm_cmplt_epi32(units, _mm_set1_epi32('z' + 1)));
+							return _mm_sub_epi32(units, _mm_and_si128(lower, _mm_set1_epi32(0x20)));
+						};
+						_mm_storeu_si128(target, fold(first));
+						_mm_storeu_si128(target + 1, fold(second));
+						return;
+					}
+				}
+			}
+#endif
+			for (std::size_t index = 0; index < count; ++index)
+				output[index] = fold_case(input[index]);
+		}
+	}
+
+	// Three-way ordinal comparison ignoring case; the result has the sign CompareStringOrdinal's would.
+	inline int compare_ignore_case(std::wstring_view left, std::wstring_view right)
+	{
+		auto const common = std::min(left.size(), right.size());
+		std::array<wchar_t, details::c_foldBlockSize> leftBlock;
+		std::array<wchar_t, details::c_foldBlockSize> rightBlock;
+		for (std::size_t offset = 0; offset < common; offset += details::c_foldBlockSize)
+		{
+			auto count = std::min(details::c_foldBlockSize, common - offset);
+			details::fold_block(left.data() + offset, count, leftBlock.data());
+			details::fold_block(right.data() + offset, count, rightBlock.data());
+			if (std::wmemcmp(leftBlock.data(), rightBlock.data(), count) == 0)
+				continue;
+
+			for (std::size_t index = 0; index < count; ++index)
+			{
+				auto leftUnit = static_cast<uint32_t>(leftBlock[index]);
+				auto rightUnit = static_cast<uint32_t>(rightBlock[index]);
+				if (leftUnit != rightUnit)
+					return leftUnit < rightUnit ? -1 : 1;
+			}
+		}
+
+		return left.size() < right.size() ? -1 : (left.size() > right.size() ? 1 : 0);
+	}
+
+	// The comparator, equality and hash below all fold the same way, so they agree with each other. They are
+	// transparent: anything convertible to std::wstring_view can be looked up without building a std::wstring.
 	struct ordinal_ignore_case_less
 	{
-		bool operator()(const std::wstring_view& left, const std::wstring_view& right) const
+		using is_transparent = void;
+
+		bool operator()(std::wstring_view left, std::wstring_view right) const
+		{
+			return compare_ignore_case(left, right) < 0;
+		}
+	};
+
+	struct ordinal_ignore_case_equal_to
+	{
+		using is_transparent = void;
+
+		bool operator()(std::wstring_view left, std::wstring_view right) const
+		{
+			return left.size() == right.size() && compare_ignore_case(left, right) == 0;
+		}
+	};
+
+	struct ordinal_ignore_case_hash
+	{
+		using is_transparent = void;
+
+		std::size_t operator()(std::wstring_view text) const
+		{
+			constexpr uint64_t c_multiplier = 0x9E3779B97F4A7C15ull;
+			uint64_t hash = text.size() * c_multiplier;
+			auto mix = [&](uint64_t word)
+			{
+				hash = (hash ^ word) * c_multiplier;
+				hash ^= hash >> 32;
+			};
+
+			std::array<wchar_t, details::c_foldBlockSize> block;
+			for (std::size_t offset = 0; offset < text.size(); offset += details::c_foldBlockSize)
+			{
+				auto count = std::min(details::c_foldBlockSize, text.size() - offset);
+				block.fill(L'\0');
+				details::fold_block(text.data() + offset, count, block.data());
+
+				std::array<uint64_t, sizeof(block) / sizeof(uint64_t)> words;
+				std::memcpy(words.data(), block.data(), sizeof(block));
+				for (auto word : words)
+					mix(word);
+			}
+
+			hash ^= hash >> 29;
+			return static_cast<std::size_t>(hash * c_multiplier);
+		}
+	};
+
+	namespace details
+	{
+		// Narrow text is folded for ASCII only, since a single byte of UTF-8 has no case of its own; wide text
+		// is folded with fold_case.
+		template <typename CharT>
+		CharT fold_unit(CharT character)
+		{
+			if constexpr (sizeof(CharT) == 1)
+				return (character >= 'a' && character <= 'z') ? static_cast<CharT>(character - 0x20) : character;
+			else
+				return fold_case(character);
+		}
+
+		template <typename CharT>
+		bool equal_ignore_case(CharT const* left, CharT const* right, std::size_t count)
+		{
+			if constexpr (sizeof(CharT) == 1)
+			{
+				for (std::size_t index = 0; index < count; ++index)
+				{
+					if (fold_unit(left[index]) != fold_unit(right[index]))
+						return false;
+				}
+				return true;
+			}
+			else
+			{
+				return compare_ignore_case({ left, count }, { right, count }) == 0;
+			}
+		}
+
+		// Only units that could fold to first need a full comparison. For an ASCII first unit those are its
+		// two cases, plus the one non-ASCII unit that folds into ASCII (dotless i to I, long s to S). For any
+		// other first unit every non-ASCII lane is folded before the comparison is tried. SSE2 tests a vector
+		// of units at a time and the remaining bits are walked in order.
+		template <typename CharT>
+		std::size_t find_ignore_case(std::basic_string_view<CharT> text, std::basic_string_view<CharT> pattern, std::size_t position)
+		{
+			if (pattern.empty())
+				return position <= text.size() ? position : std::basic_string_view<CharT>::npos;
+			if (pattern.size() > text.size())
+				return std::basic_string_view<CharT>::npos;
+
+			auto const last = text.size() - pattern.size();
+			auto const first = fold_unit(pattern[0]);
+			auto const firstValue = static_cast<uint32_t>(static_cast<std::make_unsigned_t<CharT>>(first));
+			auto const isAscii = firstValue < 0x80;
+			auto const upper = first;
+			auto const lower = (first >= 'A' && first <= 'Z') ? static_cast<CharT>(first + 0x20) : first;
+			auto const other = (sizeof(CharT) > 1 && first == 'I') ? static_cast<CharT>(0x0131)
+				: (sizeof(CharT) > 1 && first == 'S') ? static_cast<CharT>(0x017F) : first;
+
+			auto matches_at = [&](std::size_t index)
+			{
+				return (isAscii || fold_unit(text[index]) == first) && equal_ignore_case(text.data() + index, pattern.data(), pattern.size());
+			};
+
+#if defined(TAZ_UTF_SSE2)
+			constexpr std::size_t c_units = 16 / sizeof(CharT);
+			auto equals = [](__m128i units, CharT value)
+			{
+				if constexpr (sizeof(CharT) == 1)
+					return _mm_cmpeq_epi8(units, _mm_set1_epi8(static_cast<char>(value)));
+				else if constexpr (sizeof(CharT) == 2)
+					return _mm_cmpeq_epi16(units, _mm_set1_epi16(static_cast<short>(value)));
+				else
+					return _mm_cmpeq_epi32(units, _mm_set1_epi32(static_cast<int>(value)));
+			};
+			auto non_ascii = [&](__m128i units)
+			{
+				auto high = sizeof(CharT) == 2 ? _mm_set1_epi16(static_cast<short>(0xFF80)) : _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+				return _mm_andnot_si128(equals(_mm_and_si128(units, high), CharT{}), _mm_set1_epi32(-1));
+			};
+
+			for (; position + c_units <= last + 1; position += c_units)
+			{
+				auto units = _mm_loadu_si128(reinterpret_cast<__m128i const*>(text.data() + position));
+				__m128i candidates;
+				if constexpr (sizeof(CharT) == 1)
+					candidates = _mm_or_si128(equals(units, upper), equals(units, lower));
+				else if (isAscii)
+					candidates = _mm_or_si128(_mm_or_si128(equals(units, upper), equals(units, lower)), equals(units, other));
+				else
+					candidates = non_ascii(units);
+
+				// Each candidate lane sets sizeof(CharT) adjacent mask bits.
+				for (auto mask = static_cast<uint32_t>(_mm_movemask_epi8(candidates)); mask != 0; )
+				{
+					auto bit = static_cast<uint32_t>(std::countr_zero(mask));
+					mask &= ~(((1u << sizeof(CharT)) - 1) << bit);
+					auto index = position + bit / sizeof(CharT);
+					if (matches_at(index))
+						return index;
+				}
+			}
+#endif
+			for (; position <= last; ++position)
+			{
+				auto unit = text[position];
+				auto candidate = isAscii
+					? (unit == upper || unit == lower || unit == other)
+					: fold_unit(unit) == first;
+				if (candidate && equal_ignore_case(text.data() + position, pattern.data(), pattern.size()))
+					return position;
+			}
+			return std::basic_string_view<CharT>::npos;
+		}
+	}
+
+	// Ordinal case-insensitive search, folding as ordinal_ignore_case_less does for wide text and ASCII-only
+	// for narrow text. Returns npos when pattern does not occur at or after position. Nothing is copied.
+	inline std::size_t find_ignore_case(std::string_view text, std::string_view pattern, std::size_t position = 0)
+	{
+		return details::find_ignore_case(text, pattern, position);
+	}
+
+	inline std::size_t find_ignore_case(std::wstring_view text, std::wstring_view pattern, std::size_t position = 0)
+	{
+		return details::find_ignore_case(text, pattern, position);
+	}
+
+	// Lazy, non-owning range of the fields of text between occurrences of delimiter. Adjacent delimiters give
+	// empty fields and a trailing delimiter gives a trailing empty field; empty text gives no fields, and an
+	// empty delimiter gives text as the only field. Each field is a view into text, found as it is reached.
+	template <typename CharT>
+	struct basic_split_view final : std::ranges::view_interface<basic_split_view<CharT>>
+	{
+		using view_type = std::basic_string_view<CharT>;
+
+		struct iterator final
+		{
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = view_type;
+			using difference_type = std::ptrdiff_t;
+
+			iterator() = default;
+			iterator(view_type text, view_type delimiter)
+				: m_delimiter(delimiter)
+				, m_atEnd(text.empty())
+			{
+				if (!m_atEnd)
+					take_field(text);
+			}
+
+			view_type operator*() const { return m_field; }
+
+			iterator& operator++()
+			{
+				if (m_hasNext)
+					take_field(m_remaining);
+				else
+					m_atEnd = true;
+				return *this;
+			}
+
+			iterator operator++(int)
+			{
+				auto previous = *this;
+				++*this;
+				return previous;
+			}
+
+			bool operator==(iterator const& that) const
+			{
+				return m_atEnd == that.m_atEnd && (m_atEnd || m_field.data() == that.m_field.data());
+			}
+			bool operator==(std::default_sentinel_t) const { return m_atEnd; }
+
+		private:
+			void take_field(view_type text)
+			{
+				auto found = m_delimiter.empty() ? view_type::npos : text.find(m_delimiter);
+				m_hasNext = found != view_type::npos;
+				m_field = text.substr(0, found);
+				m_remaining = m_hasNext ? text.substr(found + m_delimiter.size()) : view_type{};
+			}
+
+			view_type m_field{};
+			view_type m_remaining{};
+			view_type m_delimiter{};
+			bool m_hasNext{};
+			bool m_atEnd{ true };
+		};
+
+		basic_split_view() = default;
+		basic_split_view(view_type text, view_type delimiter)
+			: m_text(text)
+			, m_delimiter(delimiter)
+		{
+		}
+
+		iterator begin() const { return { m_text, m_delimiter }; }
+		std::default_sentinel_t end() const { return {}; }
+
+	private:
+		view_type m_text{};
+		view_type m_delimiter{};
+	};
+
+	// Lazy, non-owning range of the tokens of text: maximal runs of units not in delimiters. Runs of
+	// delimiters, including leading and trailing ones, produce no empty tokens, as with strtok.
+	template <typename CharT>
+	struct basic_tokenize_view final : std::ranges::view_interface<basic_tokenize_view<CharT>>
+	{
+		using view_type = std::basic_string_view<CharT>;
+
+		struct iterator final
+		{
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = view_type;
+			using difference_type = std::ptrdiff_t;
+
+			iterator() = default;
+			iterator(view_type text, view_type delimiters)
+				: m_delimiters(delimiters)
+			{
+				take_token(text);
+			}
+
+			view_type operator*() const { return m_token; }
+
+			iterator& operator++()
+			{
+				take_token(m_remaining);
+				return *this;
+			}
+
+			iterator operator++(int)
+			{
+				auto previous = *this;
+				++*this;
+				return previous;
+			}
+
+			bool operator==(iterator const& that) const
+			{
+				return m_atEnd == that.m_atEnd && (m_atEnd || m_token.data() == that.m_token.data());
+			}
+			bool operator==(std::default_sentinel_t) const { return m_atEnd; }
+
+		private:
+			void take_token(view_type text)
+			{
+				auto start = text.find_first_not_of(m_delimiters);
+				m_atEnd = start == view_type::npos;
+				if (m_atEnd)
+					return;
+
+				auto finish = text.find_first_of(m_delimiters, start);
+				m_token = text.substr(start, finish - start);
+				m_remaining = finish == view_type::npos ? view_type{} : text.substr(finish);
+			}
+
+			view_type m_token{};
+			view_type m_remaining{};
+			view_type m_delimiters{};
+			bool m_atEnd{ true };
+		};
+
+		basic_tokenize_view() = default;
+		basic_tokenize_view(view_type text, view_type delimiters)
+			: m_text(text)
+			, m_delimiters(delimiters)
+		{
+		}
+
+		iterator begin() const { return { m_text, m_delimiters }; }
+		std::default_sentinel_t end() const { return {}; }
+
+	private:
+		view_type m_text{};
+		view_type m_delimiters{};
+	};
+
+	inline basic_split_view<char> split(std::string_view text, std::string_view delimiter)
+	{
+		return { text, delimiter };
+	}
+
+	inline basic_split_view<wchar_t> split(std::wstring_view text, std::wstring_view delimiter)
+	{
+		return { text, delimiter };
+	}
+
+	inline basic_tokenize_view<char> tokenize(std::string_view text, std::string_view delimiters = " \t\r\n")
+	{
+		return { text, delimiters };
+	}
+
+	inline basic_tokenize_view<wchar_t> tokenize(std::wstring_view text, std::wstring_view delimiters = L" \t\r\n")
+	{
+		return { text, delimiters };
+	}
+
+	template <typename CharT>
+	struct basic_atom;
+
+	namespace details
+	{
+		// Immutable once published; the text follows the header in the same arena allocation.
+		template <typename CharT>
+		struct atom_entry final
+		{
+			atom_entry const* m_next;
+			std::size_t m_hash;
+			std::size_t m_length;
+
+			CharT const* text() const { return reinterpret_cast<CharT const*>(this + 1); }
+		};
+	}
+
+	// Handle to a string interned in a basic_atom_table: one pointer, compared and hashed by identity. Atoms
+	// from the same table are equal exactly when their strings are equal under that table's Equal. The view
+	// stays valid, and null-terminated, for the life of the table. A default-constructed atom is empty.
+	template <typename CharT>
+	struct basic_atom final
+	{
+		basic_atom() = default;
+
+		std::basic_string_view<CharT> view() const
+		{
+			return m_entry ? std::basic_string_view<CharT>{ m_entry->text(), m_entry->m_length } : std::basic_string_view<CharT>{};
+		}
+		CharT const* c_str() const { return m_entry ? m_entry->text() : nullptr; }
+
+		explicit operator bool() const { return m_entry != nullptr; }
+		bool operator==(basic_atom const&) const = default;
+		std::size_t hash() const { return std::hash<void const*>{}(m_entry); }
+
+	private:
+		template <typename, typename, typename>
+		friend struct basic_atom_table;
+
+		explicit basic_atom(details::atom_entry<CharT> const* entry)
+			: m_entry(entry)
+		{
+		}
+
+		details::atom_entry<CharT> const* m_entry{};
+	};
+
+	using atom = basic_atom<char>;
+	using watom = basic_atom<wchar_t>;
+
+	// Thread-safe interning table. Strings are copied once into arena blocks and never move or get freed
+	// before the table does. Each bucket is a chain of immutable entries with an atomic head, so looking up an
+	// interned string takes no lock; adding a new one takes a lock only to allocate and publish it. The bucket
+	// count is fixed at construction, so size it for the expected number of strings.
+	template <typename CharT, typename Hash = std::hash<std::basic_string_view<CharT>>, typename Equal = std::equal_to<std::basic_string_view<CharT>>>
+	struct basic_atom_table final
+	{
+		using view_type = std::basic_string_view<CharT>;
+
+		explicit basic_atom_table(std::size_t bucketCount = 1024)
+			: m_mask(std::bit_ceil(std::max<std::size_t>(bucketCount, 1)) - 1)
+			, m_buckets(std::make_unique<std::atomic<entry const*>[]>(m_mask + 1))
+		{
+		}
+		~basic_atom_table() = default;
+
+		basic_atom_table(basic_atom_table const&) = delete;
+		basic_atom_table(basic_atom_table&&) = delete;
+		basic_atom_table& operator=(basic_atom_table const&) = delete;
+		basic_atom_table& operator=(basic_atom_table&&) = delete;
+
+		basic_atom<CharT> intern(view_type text)
 		{
-			return CSTR_LESS_THAN == CompareStringOrdinal(
-				left.data(), static_cast<int32_t>(left.length()),
-				right.data(), static_cast<int32_t>(right.length()), true);
+			auto const hash = Hash{}(text);
+			auto& bucket = m_buckets[hash & m_mask];
+			if (auto found = find_in(bucket.load(std::memory_order_acquire), text, hash))
+				return basic_atom<CharT>{ found };
+
+			std::lock_guard lock{ m_lock };
+			auto head = bucket.load(std::memory_order_relaxed);
+			if (auto found = find_in(head, text, hash))
+				return basic_atom<CharT>{ found };
+
+			auto created = allocate(text, hash, head);
+			bucket.store(created, std::memory_order_release);
+			m_size.fetch_add(1, std::memory_order_relaxed);
+			return basic_atom<CharT>{ created };
 		}
 
-		bool operator()(const std::wstring& left, const std::wstring& right) const
+		// Returns the atom for text if it has been interned, or an empty atom, without ever locking.
+		basic_atom<CharT> find(view_type text) const
 		{
-			return (*this)(std::wstring_view(left), std::wstring_view(right));
+			auto const hash = Hash{}(text);
+			return basic_atom<CharT>{ find_in(m_buckets[hash & m_mask].load(std::memory_order_acquire), text, hash) };
 		}
+
+		std::size_t size() const { return m_size.load(std::memory_order_relaxed); }
+
+	private:
+		using entry = details::atom_entry<CharT>;
+
+		inline static constexpr std::size_t c_blockSize = 64 * 1024;
+
+		static entry const* find_in(entry const* current, view_type text, std::size_t hash)
+		{
+			for (; current; current = current->m_next)
+			{
+				if (current->m_hash == hash && Equal{}(view_type{ current->text(), current->m_length }, text))
+					return current;
+			}
+			return nullptr;
+		}
+
+		// Called under m_lock.
+		entry const* allocate(view_type text, std::size_t hash, entry const* next)
+		{
+			auto const bytes = sizeof(entry) + (text.size() + 1) * sizeof(CharT);
+			auto const aligned = (bytes + alignof(entry) - 1) & ~(alignof(entry) - 1);
+			std::byte* memory{};
+			if (aligned > c_blockSize)
+			{
+				// Oversized strings get a block of their own, leaving the current block in use.
+				m_blocks.insert(m_blocks.begin(), std::make_unique<std::byte[]>(aligned));
+				memory = m_blocks.front().get();
+			}
+			else
+			{
+				if (aligned > c_blockSize - m_blockUsed)
+				{
+					m_blocks.push_back(std::make_unique<std::byte[]>(c_blockSize));
+					m_blockUsed = 0;
+				}
+
+				memory = m_blocks.back().get() + m_blockUsed;
+				m_blockUsed += aligned;
+			}
+
+			auto created = new (memory) entry{ next, hash, text.size() };
+			auto characters = reinterpret_cast<CharT*>(created + 1);
+			std::copy(text.begin(), text.end(), characters);
+			characters[text.size()] = CharT{};
+			return created;
+		}
+
+		std::size_t m_mask;
+		std::unique_ptr<std::atomic<entry const*>[]> m_buckets;
+		std::atomic<std::size_t> m_size{};
+		std::mutex m_lock{};
+		std::vector<std::unique_ptr<std::byte[]>> m_blocks{};
+		std::size_t m_blockUsed{ c_blockSize };
 	};
+
+	using atom_table = basic_atom_table<char>;
+	using watom_table = basic_atom_table<wchar_t>;
+	using wignore_case_atom_table = basic_atom_table<wchar_t, ordinal_ignore_case_hash, ordinal_ignore_case_equal_to>;
 }
+
+template <typename CharT>
+struct std::hash<taz::string_utility::basic_atom<CharT>>
+{
+	std::size_t operator()(taz::string_utility::basic_atom<CharT> const& atom) const
+	{
+		return atom.hash();
+	}
+};
+
+template <typename CharT>
+inline constexpr bool std::ranges::enable_borrowed_range<taz::string_utility::basic_split_view<CharT>> = true;
+
+template <typename CharT>
+inline constexpr bool std::ranges::enable_borrowed_range<taz::string_utility::basic_tokenize_view<CharT>> = true;
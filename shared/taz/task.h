@@ -0,0 +1,188 @@
+#pragma once
+
+// Standard C++ headers
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace taz
+{
+	template <typename T = void>
+	struct task;
+
+	namespace details
+	{
+		struct task_promise_base
+		{
+			struct final_awaiter final
+			{
+				bool await_ready() const noexcept { return false; }
+
+				template <typename Promise>
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+				{
+					auto& promise = handle.promise();
+					if (promise.m_detached)
+					{
+						// Nobody will observe the result, so the frame cleans up after itself.
+						auto exception = std::get_if<std::exception_ptr>(&promise.m_result);
+						if (exception && *exception)
+							std::terminate();
+
+						handle.destroy();
+						return std::noop_coroutine();
+					}
+
+					return promise.m_continuation ? promise.m_continuation : std::noop_coroutine();
+				}
+
+				void await_resume() const noexcept
+				{
+				}
+			};
+
+			std::suspend_always initial_suspend() const noexcept { return {}; }
+			final_awaiter final_suspend() const noexcept { return {}; }
+
+			std::coroutine_handle<> m_continuation{};
+			bool m_detached{};
+		};
+
+		template <typename T>
+		struct task_promise final : task_promise_base
+		{
+			task<T> get_return_object() noexcept;
+
+			template <typename U>
+				requires std::convertible_to<U, T>
+			void return_value(U&& value)
+			{
+				m_result.template emplace<1>(std::forward<U>(value));
+			}
+
+			void unhandled_exception() noexcept
+			{
+				m_result.template emplace<2>(std::current_exception());
+			}
+
+			T result()
+			{
+				if (m_result.index() == 2)
+					std::rethrow_exception(std::get<2>(m_result));
+
+				return std::move(std::get<1>(m_result));
+			}
+
+			std::variant<std::monostate, T, std::exception_ptr> m_result;
+		};
+
+		template <>
+		struct task_promise<void> final : task_promise_base
+		{
+			task<void> get_return_object() noexcept;
+
+			void return_void() noexcept
+			{
+			}
+
+			void unhandled_exception() noexcept
+			{
+				m_result = std::current_exception();
+			}
+
+			void result()
+			{
+				if (auto exception = std::get_if<std::exception_ptr>(&m_result); exception && *exception)
+					std::rethrow_exception(*exception);
+			}
+
+			std::variant<std::monostate, std::exception_ptr> m_result;
+		};
+	}
+
+	// Lazily started coroutine. Awaiting a task starts it and resumes the awaiter, via symmetric transfer, on
+	// whichever thread the task finishes on; combine with thread_queue::schedule() to hop between threads.
+	// detach() starts a task that nobody will await; an exception escaping a detached task terminates, as with
+	// std::thread.
+	template <typename T>
+	struct [[nodiscard]] task final
+	{
+		using promise_type = details::task_promise<T>;
+
+		task() = default;
+		explicit task(std::coroutine_handle<promise_type> handle) noexcept
+			: m_handle(handle)
+		{
+		}
+		task(task&& that) noexcept
+			: m_handle(std::exchange(that.m_handle, nullptr))
+		{
+		}
+		task& operator=(task&& that) noexcept
+		{
+			if (this != &that)
+			{
+				reset();
+				m_handle = std::exchange(that.m_handle, nullptr);
+			}
+			return *this;
+		}
+		~task()
+		{
+			reset();
+		}
+
+		task(task const&) = delete;
+		task& operator=(task const&) = delete;
+
+		bool await_ready() const noexcept
+		{
+			return !m_handle || m_handle.done();
+		}
+
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+		{
+			m_handle.promise().m_continuation = awaiting;
+			return m_handle;
+		}
+
+		T await_resume()
+		{
+			return m_handle.promise().result();
+		}
+
+		void detach() &&
+		{
+			auto handle = std::exchange(m_handle, nullptr);
+			handle.promise().m_detached = true;
+			handle.resume();
+		}
+
+		explicit operator bool() const noexcept { return static_cast<bool>(m_handle); }
+
+	private:
+		void reset() noexcept
+		{
+			if (auto handle = std::exchange(m_handle, nullptr))
+				handle.destroy();
+		}
+
+		std::coroutine_handle<promise_type> m_handle{};
+	};
+
+	namespace details
+	{
+		template <typename T>
+		inline task<T> task_promise<T>::get_return_object() noexcept
+		{
+			return task<T>{ std::coroutine_handle<task_promise<T>>::from_promise(*this) };
+		}
+
+		inline task<void> task_promise<void>::get_return_object() noexcept
+		{
+			return task<void>{ std::coroutine_handle<task_promise<void>>::from_promise(*this) };
+		}
+	}
+}
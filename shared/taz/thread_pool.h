@@ -0,0 +1,238 @@
+#pragma once
+
+// Standard C++ headers
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// tasler-cpp headers
+#include "work_item.h"
+
+namespace taz
+{
+	// Fixed set of worker threads, each with its own deque. A worker pops the newest item from its own deque
+	// and, when that is empty, steals the oldest item from the others. Items pushed from a worker thread go to
+	// that worker's deque; items pushed from anywhere else are spread round-robin.
+	template<MovableWorkItem TWorkItem>
+	struct thread_pool final
+	{
+		explicit thread_pool(std::size_t workerCount = std::max(1u, std::thread::hardware_concurrency()))
+		{
+			workerCount = std::max<std::size_t>(workerCount, 1);
+			m_workers.reserve(workerCount);
+			for (std::size_t index = 0; index < workerCount; ++index)
+			{
+				m_workers.push_back(std::make_unique<worker>());
+			}
+
+			for (std::size_t index = 0; index < workerCount; ++index)
+			{
+				m_workers[index]->m_thread = std::thread([this, index] { run(index); });
+			}
+		}
+		~thread_pool()
+		{
+			exit();
+		}
+
+		thread_pool(thread_pool const&) = delete;
+		thread_pool(thread_pool&&) = delete;
+		thread_pool& operator=(thread_pool const&) = delete;
+		thread_pool& operator=(thread_pool&&) = delete;
+
+		// Returns false, and drops the item, once exit() has been called from outside the pool: no worker might be
+		// left to run it. Items running during exit() can still push, and what they push runs before it returns.
+		bool push(TWorkItem&& workItem)
+		{
+			auto fromWorker = t_pool == this;
+			auto index = fromWorker ? t_workerIndex : m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+
+			// Counted before it is published, so that a worker which finds it never takes the count below zero,
+			// and before m_exiting is read: a worker only leaves once it has seen m_exiting and a zero count, so
+			// either this sees m_exiting or a worker sees the count.
+			m_queued.fetch_add(1, std::memory_order_seq_cst);
+			if (!fromWorker && m_exiting.load(std::memory_order_seq_cst))
+			{
+				m_queued.fetch_sub(1, std::memory_order_seq_cst);
+				return false;
+			}
+
+			m_pending.fetch_add(1, std::memory_order_seq_cst);
+			{
+				auto& target = *m_workers[index];
+				std::lock_guard lock{ target.m_lock };
+				target.m_items.push_back(std::move(workItem));
+			}
+
+			if (m_sleepers.load(std::memory_order_seq_cst) != 0)
+			{
+				std::lock_guard lock{ m_sleepLock };
+				m_wake.notify_one();
+			}
+			return true;
+		}
+
+		// Blocks until every pushed item has finished executing, then rethrows the first exception that escaped
+		// an execute() since the last call, if any.
+		void wait_idle()
+		{
+			std::exception_ptr exception;
+			{
+				std::unique_lock lock{ m_sleepLock };
+				m_idle.wait(lock, [this] { return m_pending.load(std::memory_order_acquire) == 0; });
+				exception = std::exchange(m_exception, nullptr);
+			}
+
+			if (exception)
+			{
+				std::rethrow_exception(exception);
+			}
+		}
+
+		// Runs everything already queued, then stops and joins the workers.
+		void exit()
+		{
+			{
+				std::lock_guard lock{ m_sleepLock };
+				if (m_exiting.exchange(true, std::memory_order_seq_cst))
+					return;
+			}
+			m_wake.notify_all();
+
+			for (auto& worker : m_workers)
+			{
+				if (worker->m_thread.joinable())
+					worker->m_thread.join();
+			}
+		}
+
+		std::size_t worker_count() const { return m_workers.size(); }
+
+	private:
+		struct worker final
+		{
+			std::mutex m_lock;
+			std::deque<TWorkItem> m_items;
+			std::thread m_thread;
+		};
+
+		std::optional<TWorkItem> pop_local(std::size_t index)
+		{
+			auto& self = *m_workers[index];
+			std::lock_guard lock{ self.m_lock };
+			if (self.m_items.empty())
+				return std::nullopt;
+
+			std::optional<TWorkItem> result{ std::move(self.m_items.back()) };
+			self.m_items.pop_back();
+			return result;
+		}
+
+		// A first pass only tries each lock, so that thieves don't queue up behind a busy deque; a second pass,
+		// made when items are known to be queued, waits for them.
+		std::optional<TWorkItem> steal(std::size_t thief, bool wait)
+		{
+			for (std::size_t offset = 1; offset < m_workers.size(); ++offset)
+			{
+				auto& victim = *m_workers[(thief + offset) % m_workers.size()];
+				std::unique_lock lock{ victim.m_lock, std::defer_lock };
+				if (wait)
+					lock.lock();
+				else if (!lock.try_lock())
+					continue;
+				if (victim.m_items.empty())
+					continue;
+
+				std::optional<TWorkItem> result{ std::move(victim.m_items.front()) };
+				victim.m_items.pop_front();
+				return result;
+			}
+
+			return std::nullopt;
+		}
+
+		std::optional<TWorkItem> take(std::size_t index)
+		{
+			auto workItem = pop_local(index);
+			if (!workItem)
+				workItem = steal(index, false);
+			if (!workItem && m_queued.load(std::memory_order_seq_cst) != 0)
+				workItem = steal(index, true);
+
+			if (workItem)
+				m_queued.fetch_sub(1, std::memory_order_relaxed);
+
+			return workItem;
+		}
+
+		void run(std::size_t index)
+		{
+			t_pool = this;
+			t_workerIndex = index;
+
+			for (;;)
+			{
+				if (auto workItem = take(index))
+				{
+					try
+					{
+						workItem->execute();
+					}
+					catch (...)
+					{
+						std::lock_guard lock{ m_sleepLock };
+						if (!m_exception)
+							m_exception = std::current_exception();
+					}
+
+					if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					{
+						std::lock_guard lock{ m_sleepLock };
+						m_idle.notify_all();
+					}
+					continue;
+				}
+
+				// Still counted but not found: an item is between being counted and published, or between being
+				// taken and uncounted. Either lasts a moment, so let that thread run rather than spin.
+				if (m_queued.load(std::memory_order_seq_cst) != 0)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				std::unique_lock lock{ m_sleepLock };
+				m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+				m_wake.wait(lock, [this] { return m_exiting || m_queued.load(std::memory_order_seq_cst) != 0; });
+				m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+
+				// Anything pushed by a still-running item lands on that worker's own deque, so it's safe to leave.
+				if (m_exiting && m_queued.load(std::memory_order_seq_cst) == 0)
+					return;
+			}
+		}
+
+		inline static thread_local thread_pool* t_pool{};
+		inline static thread_local std::size_t t_workerIndex{};
+
+		std::vector<std::unique_ptr<worker>> m_workers;
+		std::atomic<std::size_t> m_nextWorker{};
+		std::atomic<std::size_t> m_pending{};
+		std::atomic<std::size_t> m_queued{};
+		std::atomic<std::size_t> m_sleepers{};
+		std::mutex m_sleepLock;
+		std::condition_variable m_wake;
+		std::condition_variable m_idle;
+		std::exception_ptr m_exception{};
+		std::atomic<bool> m_exiting{};
+	};
+}
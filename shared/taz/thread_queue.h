@@ -4,73 +4,243 @@
 #include <processthreadsapi.h>
 
 // Standard C++ headers
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <span>
 #include <type_traits>
-#include <queue>
+#include <vector>
 
 // tasler-cpp headers
+#include "bounded_queue.h"
 #include "debug.h"
+#include "mpsc_queue.h"
+#include "queue_metrics.h"
+#include "range_utility.h"
+#include "work_item.h"
 
 // WIL headers
 #include <wil/resource.h>
 
 namespace taz
 {
-	template<typename TWorkItem>
-	concept WorkItem = std::move_constructible<TWorkItem>
-		&& std::copy_constructible<TWorkItem>
-		&& requires(TWorkItem& workItem)
+	// Default thread_queue backend: a vector guarded by a lock that is only held for the push or pop itself.
+	template<typename T>
+	struct locked_queue final
 	{
-		workItem.execute();
+		void push(T&& item)
+		{
+			auto lock = m_lock.lock_exclusive();
+			m_items.push_back(std::move(item));
+		}
+
+		// Elements are moved only out of an rvalue range. Returns how many were queued: all of them.
+		template<std::ranges::input_range R>
+		std::size_t push_range(R&& items)
+		{
+			auto lock = m_lock.lock_exclusive();
+			auto first = m_items.size();
+			for (auto&& item : items)
+			{
+				m_items.push_back(forward_element<R>(std::forward<decltype(item)>(item)));
+			}
+			return m_items.size() - first;
+		}
+
+		std::optional<T> try_pop()
+		{
+			auto lock = m_lock.lock_exclusive();
+			if (m_head == m_items.size())
+				return std::nullopt;
+
+			std::optional<T> result{ std::move(m_items[m_head++]) };
+			if (m_head == m_items.size())
+			{
+				m_items.clear();
+				m_head = 0;
+			}
+			else if (m_head > m_items.size() / 2)
+			{
+				m_items.erase(m_items.begin(), m_items.begin() + m_head);
+				m_head = 0;
+			}
+			return result;
+		}
+
+		// Moves everything queued into items in one step. When items is empty the two vectors are simply swapped,
+		// so the consumer's buffer is handed back to the producers and neither side reallocates.
+		void pop_all(std::vector<T>& items)
+		{
+			auto lock = m_lock.lock_exclusive();
+			if (items.empty() && m_head == 0)
+			{
+				std::swap(items, m_items);
+			}
+			else
+			{
+				std::move(m_items.begin() + m_head, m_items.end(), std::back_inserter(items));
+				m_items.clear();
+				m_head = 0;
+			}
+		}
+
+	private:
+		wil::srwlock m_lock{};
+		std::vector<T> m_items{};
+		std::size_t m_head{};
+	};
+
+	template<template<typename> typename TQueue, typename TWorkItem>
+	concept thread_queue_backend = requires(TQueue<TWorkItem>& queue, TWorkItem&& workItem)
+	{
+		queue.push(std::move(workItem));
+		{ queue.try_pop() } -> std::same_as<std::optional<TWorkItem>>;
 	};
 
-	template<WorkItem TWorkItem>
+	// When the worker thread is created: in the constructor, in the constructor but suspended until the caller
+	// resumes handle(), or by whichever push comes first. The last suits queues with static storage duration,
+	// which would otherwise start a thread during static initialization whether or not it is ever used.
+	enum class thread_start
+	{
+		immediate,
+		suspended,
+		on_first_push,
+	};
+
+	// TQueue selects the storage between producers and the worker thread: locked_queue (the default),
+	// mpsc_queue, whose producers never take a lock, or bounded<Capacity, Policy>::queue for fixed memory.
+	// TMetrics is no_queue_metrics (compiled out) or queue_metrics, which is read with metrics().snapshot().
+	template<MovableWorkItem TWorkItem, template<typename> typename TQueue = locked_queue, typename TMetrics = no_queue_metrics>
+		requires thread_queue_backend<TQueue, typename TMetrics::template entry<TWorkItem>>
 	struct thread_queue final
 	{
-		thread_queue(bool createSuspended = false)
+		using entry_type = typename TMetrics::template entry<TWorkItem>;
+
+		thread_queue(thread_start start = thread_start::immediate)
 		{
 			m_readyEvent.create(wil::EventOptions::ManualReset);
 			m_exitEvent.create(wil::EventOptions::ManualReset);
 
-			m_handle = CreateThread(nullptr, 0, thread_start_thunk, reinterpret_cast<void*>(this), createSuspended ? CREATE_SUSPENDED : 0, &m_threadId);
-			THROW_LAST_ERROR_IF_NULL(m_handle);
+			if (start != thread_start::on_first_push)
+			{
+				start_thread(start == thread_start::suspended ? CREATE_SUSPENDED : 0);
+			}
+		}
+		thread_queue(bool createSuspended)
+			: thread_queue(createSuspended ? thread_start::suspended : thread_start::immediate)
+		{
 		}
 		~thread_queue() = default;
 
-		void push(TWorkItem&& workItem)
+		// Returns false when a bounded backend dropped the item instead of queuing it.
+		bool push(TWorkItem&& workItem)
 		{
-			auto lock = m_lock.lock_exclusive();
-			m_queue.push(std::move(workItem));
-			m_readyEvent.SetEvent();
+			if (!push_entry(std::move(workItem)))
+				return false;
+
+			ensure_started();
+			signal();
+			return true;
+		}
+
+		// Queues every item in the range with a single wakeup, and a single lock when the backend supports it.
+		// Items are moved only out of an rvalue range. Returns how many were queued, which is fewer than the
+		// range holds when a bounded backend dropped some.
+		template<std::ranges::input_range R>
+			requires std::same_as<std::ranges::range_value_t<R>, TWorkItem>
+		std::size_t push_range(R&& workItems)
+		{
+			std::size_t accepted{};
+			if constexpr (!TMetrics::c_enabled && requires { { m_queue.push_range(std::forward<R>(workItems)) } -> std::same_as<std::size_t>; })
+			{
+				accepted = m_queue.push_range(std::forward<R>(workItems));
+			}
+			else
+			{
+				for (auto&& workItem : workItems)
+				{
+					if (push_entry(TWorkItem(forward_element<R>(std::forward<decltype(workItem)>(workItem)))))
+						++accepted;
+				}
+			}
+
+			if (accepted != 0)
+			{
+				ensure_started();
+				signal();
+			}
+			return accepted;
+		}
+
+		// co_await queue.schedule() resumes the awaiting coroutine on this queue's thread. The awaiter lives in the
+		// coroutine frame and is linked into the queue directly, so a hop allocates nothing.
+		struct schedule_awaiter final
+		{
+			bool await_ready() const noexcept
+			{
+				return m_queue.m_started.load(std::memory_order_acquire) && GetCurrentThreadId() == m_queue.m_threadId;
+			}
+
+			void await_suspend(std::coroutine_handle<> handle) noexcept
+			{
+				m_handle = handle;
+				m_queue.push_resumption(this);
+			}
+
+			void await_resume() const noexcept
+			{
+			}
+
+		private:
+			friend struct thread_queue;
+
+			explicit schedule_awaiter(thread_queue& queue) noexcept
+				: m_queue(queue)
+			{
+			}
+
+			thread_queue& m_queue;
+			std::coroutine_handle<> m_handle{};
+			schedule_awaiter* m_next{};
+		};
+
+		// Starts the thread here rather than in await_suspend, which must not throw: a coroutine would be left
+		// suspended with nothing to resume it.
+		[[nodiscard]] schedule_awaiter schedule()
+		{
+			ensure_started();
+			return schedule_awaiter{ *this };
 		}
 
 		void run()
 		{
 			std::array<HANDLE, 2> events = { m_exitEvent.get(), m_readyEvent.get() };
 			DWORD result{};
-			while ((result = WaitForMultipleObjects((DWORD)events.size(), events.data(), false, INFINITE)) == (WAIT_OBJECT_0 + 1))
+			DWORD timeout = INFINITE;
+			while ((result = WaitForMultipleObjects((DWORD)events.size(), events.data(), false, timeout)) == (WAIT_OBJECT_0 + 1) || result == WAIT_TIMEOUT)
 			{
-				auto lock = m_lock.lock_exclusive();
-				while (!m_queue.empty())
+				if (result == WAIT_TIMEOUT)
 				{
-					try
-					{
-						auto&& workItem = std::move(m_queue.front());
-						workItem.execute();
-						m_queue.pop();
-					}
-					catch (std::exception const& ex)
-					{
-						debug.write_line(L"taz::thread_queue::run: exception={}", ex.what());
-					}
-					catch (...)
-					{
-						debug.write_line(L"taz::thread_queue::run: unknown exception");
-					}
+					timeout = idle(false);
+					continue;
 				}
 
+				// Reset before clearing the flag so that a push which sees the flag clear always leaves the event set.
 				m_readyEvent.ResetEvent();
+				m_signaled.exchange(false, std::memory_order_acq_rel);
+
+				resume_pending();
+				execute_pending();
+
+				timeout = idle(false);
 			}
 
 			if (result == WAIT_FAILED)
@@ -78,19 +248,227 @@ namespace taz
 				debug.write_line(L"taz::thread_queue::run: WaitForMultipleObjects failed lastError={:08X}", GetLastError());
 			}
 
-			m_readyEvent.SetEvent();
+			// Whatever was queued before exit() still runs, so that no message written before shutdown is lost and
+			// no coroutine scheduled before it is left suspended.
+			if (result == WAIT_OBJECT_0)
+			{
+				resume_pending();
+				execute_pending();
+			}
+
+			idle(true);
 		}
 
+		// Returns once the worker thread has run everything queued before the call and ended. A queue whose
+		// thread never started has nothing to run, so this returns at once; called on the worker itself, it
+		// only asks the thread to end after the current item. Later and concurrent calls wait for the first.
 		void exit()
 		{
-			m_exitEvent.SetEvent();
-			m_readyEvent.wait();
+			if (!m_started.load(std::memory_order_acquire))
+				return;
+
+			std::call_once(m_exitOnce, [this]
+			{
+				m_exitEvent.SetEvent();
+				if (GetCurrentThreadId() != m_threadId)
+				{
+					WaitForSingleObject(m_handle.get(), INFINITE);
+					m_handle.reset();
+				}
+			});
 		}
 
+		TQueue<entry_type>& queue() { return m_queue; }
+		TQueue<entry_type> const& queue() const { return m_queue; }
+		TMetrics& metrics() { return m_metrics; }
+		TMetrics const& metrics() const { return m_metrics; }
+		bool started() const { return m_started.load(std::memory_order_acquire); }
 		DWORD id() const { return m_threadId; }
-		HANDLE handle() const { return m_handle; }
+		HANDLE handle() const { return m_handle.get(); }
 
 	private:
+		// After the first push this is a single load. Producers racing to make the first push all wait in
+		// call_once until one of them has created the thread.
+		void ensure_started()
+		{
+			if (!m_started.load(std::memory_order_acquire)) [[unlikely]]
+			{
+				std::call_once(m_startOnce, [this] { start_thread(0); });
+			}
+		}
+
+		void start_thread(DWORD creationFlags)
+		{
+			m_handle.reset(CreateThread(nullptr, 0, thread_start_thunk, reinterpret_cast<void*>(this), creationFlags, &m_threadId));
+			THROW_LAST_ERROR_IF_NULL(m_handle.get());
+			m_started.store(true, std::memory_order_release);
+		}
+
+		void signal()
+		{
+			// Only the first push after the worker has gone back to waiting needs to signal it.
+			if (!m_signaled.exchange(true, std::memory_order_acq_rel))
+			{
+				m_readyEvent.SetEvent();
+			}
+		}
+
+		void execute_pending()
+		{
+			// Items are executed outside of the queue's lock, so producers never wait on execute().
+			if constexpr (BatchWorkItem<TWorkItem>)
+			{
+				for (auto batch = pop_all(); !batch.empty(); batch = pop_all())
+				{
+					auto start = m_metrics.start_execute();
+					invoke_guarded([&] { TWorkItem::execute_batch(batch); });
+					m_metrics.on_executed(start, batch.size());
+					m_entries.clear();
+					m_batch.clear();
+				}
+			}
+			else
+			{
+				while (auto entry = m_queue.try_pop())
+				{
+					m_metrics.on_dequeue(*entry);
+					auto start = m_metrics.start_execute();
+					invoke_guarded([&] { TMetrics::work_item(*entry).execute(); });
+					m_metrics.on_executed(start);
+				}
+			}
+		}
+
+		// Gives an IdleWorkItem the chance to release held output, and returns how long the next wait may last.
+		DWORD idle(bool exiting)
+		{
+			if constexpr (IdleWorkItem<TWorkItem>)
+			{
+				std::chrono::milliseconds wait{ std::chrono::milliseconds::max() };
+				invoke_guarded([&] { wait = TWorkItem::on_idle(exiting); });
+				if (wait < std::chrono::milliseconds{ INFINITE })
+					return static_cast<DWORD>(std::max<std::chrono::milliseconds::rep>(wait.count(), 0));
+			}
+			return INFINITE;
+		}
+
+		bool push_entry(TWorkItem&& workItem)
+		{
+			m_metrics.on_enqueue();
+			auto entry = TMetrics::make_entry(std::move(workItem));
+			if constexpr (requires(std::size_t& evicted) { { m_queue.push(std::move(entry), evicted) } -> std::same_as<bool>; })
+			{
+				// Entries evicted to make room were counted in but will never be dequeued.
+				std::size_t evicted{};
+				auto pushed = m_queue.push(std::move(entry), evicted);
+				if (evicted != 0)
+					m_metrics.on_evicted(evicted);
+				if (!pushed)
+				{
+					m_metrics.on_dropped();
+					return false;
+				}
+			}
+			else if constexpr (std::same_as<decltype(m_queue.push(std::move(entry))), bool>)
+			{
+				if (!m_queue.push(std::move(entry)))
+				{
+					m_metrics.on_dropped();
+					return false;
+				}
+			}
+			else
+			{
+				m_queue.push(std::move(entry));
+			}
+
+			return true;
+		}
+
+		// Takes everything pending. Stamped entries are unwrapped into m_batch so execute_batch always sees a
+		// contiguous span of work items.
+		std::span<TWorkItem> pop_all()
+		{
+			if constexpr (requires { m_queue.pop_all(m_entries); })
+			{
+				m_queue.pop_all(m_entries);
+			}
+			else
+			{
+				while (auto entry = m_queue.try_pop())
+				{
+					m_entries.push_back(std::move(*entry));
+				}
+			}
+
+			if constexpr (TMetrics::c_enabled)
+			{
+				for (auto& entry : m_entries)
+				{
+					m_metrics.on_dequeue(entry);
+					m_batch.push_back(std::move(TMetrics::work_item(entry)));
+				}
+				m_entries.clear();
+				return m_batch;
+			}
+			else
+			{
+				return m_entries;
+			}
+		}
+
+		void push_resumption(schedule_awaiter* awaiter) noexcept
+		{
+			auto head = m_resumptions.load(std::memory_order_relaxed);
+			do
+			{
+				awaiter->m_next = head;
+			} while (!m_resumptions.compare_exchange_weak(head, awaiter, std::memory_order_release, std::memory_order_relaxed));
+
+			// schedule() has already started the thread.
+			signal();
+		}
+
+		void resume_pending()
+		{
+			// The list is pushed LIFO; reverse it so coroutines resume in the order they were scheduled.
+			schedule_awaiter* ordered{};
+			for (auto awaiter = m_resumptions.exchange(nullptr, std::memory_order_acquire); awaiter; )
+			{
+				auto next = awaiter->m_next;
+				awaiter->m_next = ordered;
+				ordered = awaiter;
+				awaiter = next;
+			}
+
+			while (ordered)
+			{
+				// Resuming may complete the coroutine and free the awaiter, so read the link first.
+				auto handle = ordered->m_handle;
+				ordered = ordered->m_next;
+				invoke_guarded([&] { handle.resume(); });
+			}
+		}
+
+		template<typename Fn>
+		void invoke_guarded(Fn&& function)
+		{
+			try
+			{
+				function();
+			}
+			catch (std::exception const& ex)
+			{
+				m_metrics.on_exception();
+				debug.write_line(L"taz::thread_queue::run: exception={}", ex.what());
+			}
+			catch (...)
+			{
+				m_metrics.on_exception();
+				debug.write_line(L"taz::thread_queue::run: unknown exception");
+			}
+		}
+
 		static DWORD WINAPI thread_start_thunk(void* param)
 		{
 			auto& thisref = *reinterpret_cast<thread_queue*>(param);
@@ -103,11 +481,18 @@ namespace taz
 		thread_queue& operator=(thread_queue const&) = delete;
 		thread_queue& operator=(thread_queue&&) = delete;
 
-		wil::srwlock m_lock{};
+		TQueue<entry_type> m_queue{};
+		std::vector<entry_type> m_entries{};
+		std::vector<TWorkItem> m_batch{};
+		TAZ_NO_UNIQUE_ADDRESS TMetrics m_metrics{};
+		std::atomic<schedule_awaiter*> m_resumptions{};
+		std::atomic<bool> m_signaled{};
+		std::atomic<bool> m_started{};
+		std::once_flag m_startOnce{};
+		std::once_flag m_exitOnce{};
 		wil::unique_event m_readyEvent{};
 		wil::unique_event m_exitEvent{};
-		std::queue<TWorkItem> m_queue{};
 		DWORD m_threadId{};
-		HANDLE m_handle{};
+		wil::unique_handle m_handle{};
 	};
 }
@@ -7,6 +7,7 @@
 #include <winuser.h>
 
 #include <algorithm>
+#include <array>
 #include <cctype>
 #include <cstdint>
 #include <optional>
@@ -18,10 +19,19 @@
 #include "..\debug.h"
 #include "..\error_utility.h"
 #include "..\formatters.h"
+#include "..\string_utility.h"
 #include "resize_type.h"
 
+#include <wil\result.h>
+
 namespace taz::ui
 {
+	namespace details
+	{
+		// Shared by every window type; class names are compared without case, as Windows does.
+		inline string_utility::wignore_case_atom_table s_classNames{ 256 };
+	}
+
 	template<typename TDerived>
 	struct window_base
 	{
@@ -72,6 +82,15 @@ namespace taz::ui
 			return className;
 		}
 
+		// Interned class name: no allocation once the class has been seen, and comparing two is a pointer compare.
+		string_utility::watom class_atom() const
+		{
+			std::array<wchar_t, 257> className{};
+			auto classNameLength = GetClassNameW(m_hwnd, className.data(), static_cast<int32_t>(className.size()));
+			THROW_LAST_ERROR_IF(classNameLength == 0);
+			return details::s_classNames.intern({ className.data(), static_cast<std::size_t>(classNameLength) });
+		}
+
 	private:
 		static window_base<TDerived>* window_base_from_hwnd(HWND hwnd, bool throwOnNull = true);
 		LRESULT window_proc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
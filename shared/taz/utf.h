@@ -0,0 +1,500 @@
+#pragma once
+
+// Standard C++ headers
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+#if defined(__AVX2__)
+#define TAZ_UTF_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TAZ_UTF_SSE2 1
+#endif
+#if defined(TAZ_UTF_SSE2) || defined(TAZ_UTF_AVX2)
+#include <immintrin.h>
+#endif
+
+// Portable UTF-8 <-> wide transcoding. Wide strings are UTF-16 when the code unit is 16 bits (wchar_t on Windows,
+// char16_t) and UTF-32 when it is 32 bits (wchar_t on Linux, char32_t). Runs of ASCII are converted 16 or 32
+// units at a time with SSE2/AVX2 when the compiler targets them, and 8 at a time with plain 64-bit words
+// otherwise. Ill-formed input is never rejected: every maximal ill-formed subpart becomes one U+FFFD, as
+// recommended by Unicode and as done by MultiByteToWideChar/WideCharToMultiByte.
+namespace taz::utf
+{
+	template <typename T>
+	concept wide_character = std::same_as<T, wchar_t> || std::same_as<T, char16_t> || std::same_as<T, char32_t>;
+
+	inline constexpr char32_t c_replacementCharacter = 0xFFFD;
+
+	enum class conversion_status : uint8_t
+	{
+		ok,
+		output_too_small,  // The output filled up; m_read tells how much input was consumed.
+		incomplete_input,  // The input ends inside a sequence that may be completed by more input.
+	};
+
+	struct conversion_result final
+	{
+		std::size_t m_read{};
+		std::size_t m_written{};
+		std::size_t m_replacements{};
+		conversion_status m_status{};
+
+		bool ok() const { return m_status == conversion_status::ok; }
+	};
+
+	// Output capacities that are always large enough for a whole input of the given length.
+	constexpr std::size_t max_wide_length(std::size_t utf8Length)
+	{
+		return utf8Length;
+	}
+
+	template <wide_character W>
+	constexpr std::size_t max_utf8_length(std::size_t wideLength)
+	{
+		return wideLength * (sizeof(W) == 2 ? 3 : 4);
+	}
+
+	namespace details
+	{
+		struct decoded final
+		{
+			char32_t m_codePoint;
+			uint8_t m_length;
+			bool m_valid;
+			bool m_truncated;  // Every byte up to the end of the input was a valid prefix.
+		};
+
+		// Decodes the sequence at input[0]. On error m_length is the maximal subpart to replace.
+		constexpr decoded decode_utf8(unsigned char const* input, std::size_t available)
+		{
+			auto lead = input[0];
+			if (lead < 0x80)
+				return { lead, 1, true, false };
+
+			std::size_t trailing{};
+			char32_t codePoint{};
+			unsigned char low = 0x80;
+			unsigned char high = 0xBF;
+			if (lead >= 0xC2 && lead <= 0xDF)
+			{
+				trailing = 1;
+				codePoint = lead & 0x1F;
+			}
+			else if (lead >= 0xE0 && lead <= 0xEF)
+			{
+				trailing = 2;
+				codePoint = lead & 0x0F;
+				if (lead == 0xE0)
+					low = 0xA0;
+				else if (lead == 0xED)
+					high = 0x9F;
+			}
+			else if (lead >= 0xF0 && lead <= 0xF4)
+			{
+				trailing = 3;
+				codePoint = lead & 0x07;
+				if (lead == 0xF0)
+					low = 0x90;
+				else if (lead == 0xF4)
+					high = 0x8F;
+			}
+			else
+			{
+				return { c_replacementCharacter, 1, false, false };
+			}
+
+			for (std::size_t index = 1; index <= trailing; ++index)
+			{
+				if (index >= available)
+					return { c_replacementCharacter, static_cast<uint8_t>(index), false, true };
+
+				auto byte = input[index];
+				if (byte < low || byte > high)
+					return { c_replacementCharacter, static_cast<uint8_t>(index), false, false };
+
+				low = 0x80;
+				high = 0xBF;
+				codePoint = (codePoint << 6) | (byte & 0x3F);
+			}
+
+			return { codePoint, static_cast<uint8_t>(trailing + 1), true, false };
+		}
+
+		template <wide_character W>
+		constexpr std::size_t wide_units(char32_t codePoint)
+		{
+			return (sizeof(W) == 2 && codePoint > 0xFFFF) ? 2 : 1;
+		}
+
+		template <wide_character W>
+		constexpr W* encode_wide(char32_t codePoint, W* output)
+		{
+			if (sizeof(W) == 2 && codePoint > 0xFFFF)
+			{
+				codePoint -= 0x10000;
+				*output++ = static_cast<W>(0xD800 + (codePoint >> 10));
+				*output++ = static_cast<W>(0xDC00 + (codePoint & 0x3FF));
+				return output;
+			}
+
+			*output++ = static_cast<W>(codePoint);
+			return output;
+		}
+
+		constexpr std::size_t utf8_units(char32_t codePoint)
+		{
+			return codePoint < 0x80 ? 1 : codePoint < 0x800 ? 2 : codePoint < 0x10000 ? 3 : 4;
+		}
+
+		inline char* encode_utf8(char32_t codePoint, char* output)
+		{
+			if (codePoint < 0x80)
+			{
+				*output++ = static_cast<char>(codePoint);
+			}
+			else if (codePoint < 0x800)
+			{
+				*output++ = static_cast<char>(0xC0 | (codePoint >> 6));
+				*output++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+			else if (codePoint < 0x10000)
+			{
+				*output++ = static_cast<char>(0xE0 | (codePoint >> 12));
+				*output++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				*output++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+			else
+			{
+				*output++ = static_cast<char>(0xF0 | (codePoint >> 18));
+				*output++ = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+				*output++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				*output++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+			return output;
+		}
+
+		struct decoded_wide final
+		{
+			char32_t m_codePoint;
+			uint8_t m_length;
+			bool m_valid;
+			bool m_truncated;  // A high surrogate was the last unit of the input.
+		};
+
+		template <wide_character W>
+		inline decoded_wide decode_wide(W const* input, std::size_t available)
+		{
+			auto unit = static_cast<char32_t>(input[0]);
+			if constexpr (sizeof(W) == 2)
+			{
+				if (unit >= 0xD800 && unit <= 0xDBFF)
+				{
+					if (available < 2)
+						return { c_replacementCharacter, 1, false, true };
+
+					auto next = static_cast<char32_t>(input[1]);
+					if (next >= 0xDC00 && next <= 0xDFFF)
+						return { 0x10000 + ((unit - 0xD800) << 10) + (next - 0xDC00), 2, true, false };
+				}
+				if (unit >= 0xD800 && unit <= 0xDFFF)
+					return { c_replacementCharacter, 1, false, false };
+			}
+			else
+			{
+				if ((unit >= 0xD800 && unit <= 0xDFFF) || unit > 0x10FFFF)
+					return { c_replacementCharacter, 1, false, false };
+			}
+
+			return { unit, 1, true, false };
+		}
+
+		// Converts whole blocks of ASCII from the front of the input; returns the number of units converted.
+		// count is the smaller of the input length and the output capacity.
+		template <wide_character W>
+		inline std::size_t widen_ascii(unsigned char const* input, std::size_t count, W* output)
+		{
+			std::size_t index{};
+#if defined(TAZ_UTF_AVX2)
+			for (; index + 32 <= count; index += 32)
+			{
+				auto bytes = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(input + index));
+				if (_mm256_movemask_epi8(bytes) != 0)
+					return index;
+
+				auto low = _mm256_castsi256_si128(bytes);
+				auto high = _mm256_extracti128_si256(bytes, 1);
+				if constexpr (sizeof(W) == 2)
+				{
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + index), _mm256_cvtepu8_epi16(low));
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + index + 16), _mm256_cvtepu8_epi16(high));
+				}
+				else
+				{
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + index), _mm256_cvtepu8_epi32(low));
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + index + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(low, 8)));
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + index + 16), _mm256_cvtepu8_epi32(high));
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + index + 24), _mm256_cvtepu8_epi32(_mm_srli_si128(high, 8)));
+				}
+			}
+#endif
+#if defined(TAZ_UTF_SSE2)
+			auto zero = _mm_setzero_si128();
+			for (; index + 16 <= count; index += 16)
+			{
+				auto bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input + index));
+				if (_mm_movemask_epi8(bytes) != 0)
+					return index;
+
+				auto low = _mm_unpacklo_epi8(bytes, zero);
+				auto high = _mm_unpackhi_epi8(bytes, zero);
+				if constexpr (sizeof(W) == 2)
+				{
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(output + index), low);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(output + index + 8), high);
+				}
+				else
+				{
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(output + index), _mm_unpacklo_epi16(low, zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(output + index + 4), _mm_unpackhi_epi16(low, zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(output + index + 8), _mm_unpacklo_epi16(high, zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(output + index + 12), _mm_unpackhi_epi16(high, zero));
+				}
+			}
+#endif
+			for (; index + 8 <= count; index += 8)
+			{
+				uint64_t word;
+				std::memcpy(&word, input + index, sizeof(word));
+				if (word & 0x8080808080808080ull)
+					return index;
+
+				for (std::size_t offset = 0; offset < 8; ++offset)
+					output[index + offset] = static_cast<W>(input[index + offset]);
+			}
+			return index;
+		}
+
+		template <wide_character W>
+		inline std::size_t narrow_ascii(W const* input, std::size_t count, char* output)
+		{
+			std::size_t index{};
+#if defined(TAZ_UTF_AVX2)
+			if constexpr (sizeof(W) == 2)
+			{
+				auto mask = _mm256_set1_epi16(static_cast<short>(0xFF80));
+				for (; index + 32 <= count; index += 32)
+				{
+					auto first = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(input + index));
+					auto second = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(input + index + 16));
+					if (!_mm256_testz_si256(_mm256_or_si256(first, second), mask))
+						return index;
+
+					auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(first, second), 0xD8);
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + index), packed);
+				}
+			}
+#endif
+#if defined(TAZ_UTF_SSE2)
+			auto zero = _mm_setzero_si128();
+			for (; index + 16 <= count; index += 16)
+			{
+				auto source = reinterpret_cast<__m128i const*>(input + index);
+				__m128i packed;
+				if constexpr (sizeof(W) == 2)
+				{
+					auto first = _mm_loadu_si128(source);
+					auto second = _mm_loadu_si128(source + 1);
+					auto high = _mm_and_si128(_mm_or_si128(first, second), _mm_set1_epi16(static_cast<short>(0xFF80)));
+					if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xFFFF)
+						return index;
+
+					packed = _mm_packus_epi16(first, second);
+				}
+				else
+				{
+					auto a = _mm_loadu_si128(source);
+					auto b = _mm_loadu_si128(source + 1);
+					auto c = _mm_loadu_si128(source + 2);
+					auto d = _mm_loadu_si128(source + 3);
+					auto any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+					auto high = _mm_and_si128(any, _mm_set1_epi32(static_cast<int>(0xFFFFFF80)));
+					if (_mm_movemask_epi8(_mm_cmpeq_epi32(high, zero)) != 0xFFFF)
+						return index;
+
+					packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+				}
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(output + index), packed);
+			}
+#endif
+			for (; index < count && static_cast<char32_t>(input[index]) < 0x80; ++index)
+			{
+				output[index] = static_cast<char>(input[index]);
+			}
+			return index;
+		}
+
+		inline std::size_t ascii_prefix_length(unsigned char const* input, std::size_t count)
+		{
+			std::size_t index{};
+#if defined(TAZ_UTF_SSE2)
+			for (; index + 16 <= count; index += 16)
+			{
+				if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(input + index))) != 0)
+					break;
+			}
+#endif
+			for (; index + 8 <= count; index += 8)
+			{
+				uint64_t word;
+				std::memcpy(&word, input + index, sizeof(word));
+				if (word & 0x8080808080808080ull)
+					break;
+			}
+			while (index < count && input[index] < 0x80)
+				++index;
+			return index;
+		}
+	}
+
+	// Converts UTF-8 to UTF-16/UTF-32 in one pass. Stops early when output is full, and, when endOfInput is
+	// false, leaves a trailing partial sequence unread so it can be completed by the next chunk.
+	template <wide_character W>
+	inline conversion_result utf8_to_wide(std::string_view input, std::span<W> output, bool endOfInput = true)
+	{
+		auto source = reinterpret_cast<unsigned char const*>(input.data());
+		auto const length = input.size();
+		auto const capacity = output.size();
+		conversion_result result;
+		std::size_t read{};
+		std::size_t written{};
+
+		while (read < length)
+		{
+			auto ascii = details::widen_ascii(source + read, std::min(length - read, capacity - written), output.data() + written);
+			read += ascii;
+			written += ascii;
+			if (read == length)
+				break;
+
+			auto decoded = details::decode_utf8(source + read, length - read);
+			if (decoded.m_truncated && !endOfInput)
+			{
+				result.m_status = conversion_status::incomplete_input;
+				break;
+			}
+
+			if (written + details::wide_units<W>(decoded.m_codePoint) > capacity)
+			{
+				result.m_status = conversion_status::output_too_small;
+				break;
+			}
+
+			written = details::encode_wide(decoded.m_codePoint, output.data() + written) - output.data();
+			read += decoded.m_length;
+			result.m_replacements += decoded.m_valid ? 0 : 1;
+		}
+
+		result.m_read = read;
+		result.m_written = written;
+		return result;
+	}
+
+	// Converts UTF-16/UTF-32 to UTF-8 in one pass, with the same early-stop rules as utf8_to_wide.
+	template <wide_character W>
+	inline conversion_result wide_to_utf8(std::basic_string_view<W> input, std::span<char> output, bool endOfInput = true)
+	{
+		auto const length = input.size();
+		auto const capacity = output.size();
+		conversion_result result;
+		std::size_t read{};
+		std::size_t written{};
+
+		while (read < length)
+		{
+			auto ascii = details::narrow_ascii(input.data() + read, std::min(length - read, capacity - written), output.data() + written);
+			read += ascii;
+			written += ascii;
+			if (read == length)
+				break;
+
+			auto decoded = details::decode_wide(input.data() + read, length - read);
+			if (decoded.m_truncated && !endOfInput)
+			{
+				result.m_status = conversion_status::incomplete_input;
+				break;
+			}
+
+			if (written + details::utf8_units(decoded.m_codePoint) > capacity)
+			{
+				result.m_status = conversion_status::output_too_small;
+				break;
+			}
+
+			written = details::encode_utf8(decoded.m_codePoint, output.data() + written) - output.data();
+			read += decoded.m_length;
+			result.m_replacements += decoded.m_valid ? 0 : 1;
+		}
+
+		result.m_read = read;
+		result.m_written = written;
+		return result;
+	}
+
+	// Exact number of wide units utf8_to_wide will write for the whole input.
+	template <wide_character W>
+	inline std::size_t wide_length(std::string_view input)
+	{
+		auto source = reinterpret_cast<unsigned char const*>(input.data());
+		std::size_t units{};
+		for (std::size_t read = 0; read < input.size(); )
+		{
+			auto ascii = details::ascii_prefix_length(source + read, input.size() - read);
+			read += ascii;
+			units += ascii;
+			if (read == input.size())
+				break;
+
+			auto decoded = details::decode_utf8(source + read, input.size() - read);
+			units += details::wide_units<W>(decoded.m_codePoint);
+			read += decoded.m_length;
+		}
+		return units;
+	}
+
+	// Exact number of bytes wide_to_utf8 will write for the whole input.
+	template <wide_character W>
+	inline std::size_t utf8_length(std::basic_string_view<W> input)
+	{
+		std::size_t bytes{};
+		for (std::size_t read = 0; read < input.size(); )
+		{
+			auto decoded = details::decode_wide(input.data() + read, input.size() - read);
+			bytes += details::utf8_units(decoded.m_codePoint);
+			read += decoded.m_length;
+		}
+		return bytes;
+	}
+
+	inline bool is_valid_utf8(std::string_view input)
+	{
+		auto source = reinterpret_cast<unsigned char const*>(input.data());
+		for (std::size_t read = 0; read < input.size(); )
+		{
+			read += details::ascii_prefix_length(source + read, input.size() - read);
+			if (read == input.size())
+				break;
+
+			auto decoded = details::decode_utf8(source + read, input.size() - read);
+			if (!decoded.m_valid)
+				return false;
+			read += decoded.m_length;
+		}
+		return true;
+	}
+}
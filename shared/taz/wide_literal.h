@@ -0,0 +1,81 @@
+#pragma once
+
+// Standard C++ headers
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+// tasler-cpp headers
+#include "utf.h"
+
+namespace taz
+{
+	// A narrow string literal captured as a template argument.
+	template <std::size_t N>
+	struct fixed_literal final
+	{
+		consteval fixed_literal(char const (&text)[N])
+		{
+			for (std::size_t index = 0; index < N; ++index)
+				m_text[index] = text[index];
+		}
+
+		constexpr std::size_t size() const { return N - 1; }
+
+		char m_text[N]{};
+	};
+
+	namespace details
+	{
+		// Walks the UTF-8 literal, writing wide units when output is non-null, and returns how many it takes.
+		// Ill-formed UTF-8 reaches the throw, which is not a constant expression and so fails the build.
+		template <std::size_t N>
+		constexpr std::size_t widen_literal(fixed_literal<N> const& literal, wchar_t* output)
+		{
+			std::array<unsigned char, N> bytes{};
+			for (std::size_t index = 0; index < N; ++index)
+				bytes[index] = static_cast<unsigned char>(literal.m_text[index]);
+
+			std::size_t units{};
+			for (std::size_t read = 0; read < literal.size(); )
+			{
+				auto decoded = utf::details::decode_utf8(bytes.data() + read, literal.size() - read);
+				if (!decoded.m_valid)
+					throw "string literal is not valid UTF-8; compile with /utf-8";
+
+				if (output)
+					utf::details::encode_wide(decoded.m_codePoint, output + units);
+				units += utf::details::wide_units<wchar_t>(decoded.m_codePoint);
+				read += decoded.m_length;
+			}
+			return units;
+		}
+
+		template <fixed_literal Literal>
+		consteval auto make_wide_literal()
+		{
+			std::array<wchar_t, widen_literal(Literal, nullptr) + 1> wide{};
+			widen_literal(Literal, wide.data());
+			return wide;
+		}
+
+		template <fixed_literal Literal>
+		inline constexpr auto c_wideLiteral = make_wide_literal<Literal>();
+	}
+
+	// wide<"text"> is the UTF-16 (or UTF-32) form of a UTF-8 literal, converted by the compiler into static
+	// storage and null-terminated. Handy where only a narrow literal is at hand, e.g. one built by a macro, and
+	// for format strings that go to wide writers such as console_output without a runtime widen.
+	template <fixed_literal Literal>
+	inline constexpr std::wstring_view wide{ details::c_wideLiteral<Literal>.data(), details::c_wideLiteral<Literal>.size() - 1 };
+
+	inline namespace literals
+	{
+		// "text"_w is shorthand for wide<"text">.
+		template <fixed_literal Literal>
+		consteval std::wstring_view operator""_w()
+		{
+			return wide<Literal>;
+		}
+	}
+}
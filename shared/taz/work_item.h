@@ -0,0 +1,40 @@
+#pragma once
+
+// Standard C++ headers
+#include <chrono>
+#include <concepts>
+#include <span>
+
+namespace taz
+{
+	// What thread_queue and thread_pool require: a work item is only ever moved, never copied.
+	template<typename TWorkItem>
+	concept MovableWorkItem = std::move_constructible<TWorkItem>
+		&& requires(TWorkItem& workItem)
+	{
+		workItem.execute();
+	};
+
+	template<typename TWorkItem>
+	concept WorkItem = MovableWorkItem<TWorkItem>
+		&& std::copy_constructible<TWorkItem>;
+
+	// A work item that can also execute everything drained from the queue in one call, e.g. to write many
+	// messages with a single system call. Consumers that see this call execute_batch instead of execute.
+	template<typename TWorkItem>
+	concept BatchWorkItem = MovableWorkItem<TWorkItem>
+		&& requires(std::span<TWorkItem> workItems)
+	{
+		TWorkItem::execute_batch(workItems);
+	};
+
+	// A work item whose execute_batch may hold output back, e.g. to coalesce writes. The consumer calls
+	// on_idle(false) each time it runs out of work and calls it again if nothing arrives within the returned
+	// time (duration::max() to wait indefinitely). on_idle(true) is the last call, made as the consumer exits.
+	template<typename TWorkItem>
+	concept IdleWorkItem = MovableWorkItem<TWorkItem>
+		&& requires(bool exiting)
+	{
+		{ TWorkItem::on_idle(exiting) } -> std::convertible_to<std::chrono::milliseconds>;
+	};
+}
\ No newline at end of file
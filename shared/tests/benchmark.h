@@ -0,0 +1,45 @@
+#pragma once
+
+// Standard C headers
+#include <stdio.h>
+
+// Standard C++ headers
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+
+namespace benchmark
+{
+	// Runs fn a few times and returns the fastest run in seconds, which is the one least disturbed by the rest of
+	// the machine.
+	template <typename Fn>
+	double best_seconds(Fn&& fn, int runs = 5)
+	{
+		auto best = std::numeric_limits<double>::max();
+		for (int run = 0; run < runs; ++run)
+		{
+			auto start = std::chrono::steady_clock::now();
+			fn();
+			best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+		return best;
+	}
+
+	// Stores a result where the optimizer can't see it being unused.
+	inline void keep(std::size_t value)
+	{
+		static std::size_t volatile s_sink{};
+		s_sink = value;
+	}
+
+	inline void report(char const* name, double seconds, std::size_t operations, char const* unit = "op")
+	{
+		printf("%-48s %10.2f ns/%s\n", name, seconds * 1e9 / static_cast<double>(operations), unit);
+	}
+
+	inline void report_throughput(char const* name, double seconds, std::size_t bytes)
+	{
+		printf("%-48s %10.1f MB/s\n", name, static_cast<double>(bytes) / seconds / 1e6);
+	}
+}
@@ -0,0 +1,92 @@
+// Standard C++ headers
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+// tasler-cpp headers
+#include "taz/bounded_queue.h"
+
+// Local headers
+#include "check.h"
+
+namespace
+{
+	// Every item pushed is either popped or counted as dropped, and each producer's items arrive in order.
+	template <taz::overflow_policy Policy>
+	void check_policy()
+	{
+		constexpr int c_producers = 4;
+		constexpr int c_items = 10000;
+		taz::bounded_queue<std::string, 64, Policy> queue;
+
+		std::vector<std::thread> producers;
+		for (int producer = 0; producer < c_producers; ++producer)
+		{
+			producers.emplace_back([&queue, producer]
+			{
+				for (int item = 0; item < c_items; ++item)
+					queue.push(std::to_string(producer * c_items + item));
+			});
+		}
+
+		std::atomic<bool> done{};
+		long popped{};
+		std::thread consumer([&]
+		{
+			std::vector<long> last(c_producers, -1);
+			for (;;)
+			{
+				auto finished = done.load();
+				auto item = queue.try_pop();
+				if (!item)
+				{
+					if (finished)
+						break;
+					std::this_thread::yield();
+					continue;
+				}
+
+				auto value = std::stol(*item);
+				auto& previous = last[value / c_items];
+				TAZ_CHECK(value > previous);
+				previous = value;
+				++popped;
+			}
+		});
+
+		for (auto& producer : producers)
+			producer.join();
+		done = true;
+		consumer.join();
+
+		TAZ_CHECK(popped + static_cast<long>(queue.dropped()) == c_producers * c_items);
+		if constexpr (Policy == taz::overflow_policy::block || Policy == taz::overflow_policy::spin_then_block)
+			TAZ_CHECK(queue.dropped() == 0);
+	}
+
+	// Under drop_oldest the caller is told how many queued items each push evicted.
+	void check_evicted()
+	{
+		taz::bounded_queue<int, 4, taz::overflow_policy::drop_oldest> queue;
+		std::size_t evicted{};
+		for (int item = 0; item < 10; ++item)
+			TAZ_CHECK(queue.push(int{ item }, evicted));
+
+		TAZ_CHECK(evicted == 6 && queue.dropped_oldest() == 6);
+		for (int item = 6; item < 10; ++item)
+			TAZ_CHECK(*queue.try_pop() == item);
+		TAZ_CHECK(!queue.try_pop());
+	}
+}
+
+int main()
+{
+	check_policy<taz::overflow_policy::block>();
+	check_policy<taz::overflow_policy::spin_then_block>();
+	check_policy<taz::overflow_policy::drop_newest>();
+	check_policy<taz::overflow_policy::drop_oldest>();
+	check_evicted();
+	return 0;
+}
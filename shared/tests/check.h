@@ -0,0 +1,16 @@
+#pragma once
+
+// Standard C headers
+#include <stdio.h>
+#include <stdlib.h>
+
+// Unlike assert, stays active in release builds so the tests check optimized code too.
+#define TAZ_CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); \
+			exit(1); \
+		} \
+	} while (false)
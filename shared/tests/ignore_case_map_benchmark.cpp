@@ -0,0 +1,123 @@
+// Standard C headers
+#include <stdio.h>
+
+// Standard C++ headers
+#include <cstddef>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// tasler-cpp headers
+#include "taz/ignore_case_map.h"
+
+// Local headers
+#include "benchmark.h"
+
+using namespace taz;
+
+namespace
+{
+	// Names shaped like environment variables and window classes: a shared prefix, then a distinguishing tail.
+	std::vector<std::wstring> make_keys(std::size_t count, std::mt19937& random)
+	{
+		constexpr wchar_t const* c_prefixes[] = { L"PROCESSOR_", L"Windows.UI.Core.", L"Afx:", L"HKEY_LOCAL_MACHINE\\Software\\", L"X" };
+		std::vector<std::wstring> keys;
+		for (std::size_t index = 0; index < count; ++index)
+		{
+			std::wstring key = c_prefixes[random() % std::size(c_prefixes)];
+			for (auto length = 4 + random() % 12; length > 0; --length)
+				key.push_back(static_cast<wchar_t>(L'a' + random() % 26));
+			keys.push_back(std::move(key) + std::to_wstring(index));
+		}
+		return keys;
+	}
+
+	// The same key with its case scrambled, as lookups usually arrive.
+	std::wstring scramble(std::wstring key, std::mt19937& random)
+	{
+		for (auto& character : key)
+		{
+			if (random() % 2)
+				character = string_utility::fold_case(character);
+		}
+		return key;
+	}
+
+	template <typename Map>
+	void measure(char const* name, Map const& map, std::vector<std::wstring> const& hits, std::vector<std::wstring> const& misses)
+	{
+		auto seconds = benchmark::best_seconds([&]
+		{
+			std::size_t found{};
+			for (auto const& key : hits)
+				found += map.find(key) != map.end();
+			benchmark::keep(found);
+		});
+		benchmark::report((std::string{ "  find hit, " } + name).c_str(), seconds, hits.size(), "lookup");
+
+		seconds = benchmark::best_seconds([&]
+		{
+			std::size_t found{};
+			for (auto const& key : misses)
+				found += map.find(key) != map.end();
+			benchmark::keep(found);
+		});
+		benchmark::report((std::string{ "  find miss, " } + name).c_str(), seconds, misses.size(), "lookup");
+	}
+}
+
+int main()
+{
+	using reference_map = std::map<std::wstring, int, string_utility::ordinal_ignore_case_less>;
+
+	for (std::size_t count : { 64u, 1'024u, 65'536u })
+	{
+		std::mt19937 random{ 5 };
+		auto keys = make_keys(count, random);
+		auto missKeys = make_keys(count, random);
+		for (auto& key : missKeys)
+			key += L"~";
+
+		std::vector<std::wstring> hits;
+		std::vector<std::wstring> misses;
+		for (std::size_t lookup = 0; lookup < 1'000'000; ++lookup)
+		{
+			hits.push_back(scramble(keys[random() % count], random));
+			misses.push_back(missKeys[random() % count]);
+		}
+
+		reference_map reference;
+		ignore_case_hash_map<int> hashMap;
+		std::vector<std::pair<std::wstring, int>> entries;
+		printf("\n%zu keys\n", count);
+
+		auto seconds = benchmark::best_seconds([&]
+		{
+			reference.clear();
+			for (std::size_t index = 0; index < count; ++index)
+				reference.insert_or_assign(keys[index], static_cast<int>(index));
+		});
+		benchmark::report("  build, std::map", seconds, count, "key");
+
+		seconds = benchmark::best_seconds([&]
+		{
+			hashMap.clear();
+			for (std::size_t index = 0; index < count; ++index)
+				hashMap.insert_or_assign(keys[index], static_cast<int>(index));
+		});
+		benchmark::report("  build, ignore_case_hash_map", seconds, count, "key");
+
+		for (std::size_t index = 0; index < count; ++index)
+			entries.emplace_back(keys[index], static_cast<int>(index));
+		ignore_case_flat_map<int> flatMap;
+		seconds = benchmark::best_seconds([&] { flatMap = ignore_case_flat_map<int>{ entries }; });
+		benchmark::report("  build from a vector, ignore_case_flat_map", seconds, count, "key");
+
+		measure("std::map", reference, hits, misses);
+		measure("ignore_case_hash_map", hashMap, hits, misses);
+		measure("ignore_case_flat_map", flatMap, hits, misses);
+	}
+	return 0;
+}
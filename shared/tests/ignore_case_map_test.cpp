@@ -0,0 +1,129 @@
+// Standard C++ headers
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// tasler-cpp headers
+#include "taz/ignore_case_map.h"
+
+// Local headers
+#include "check.h"
+
+using namespace taz;
+
+int main()
+{
+	std::mt19937 random{ 11 };
+	constexpr wchar_t c_alphabet[] = L"aAbB_Zz";
+	for (int round = 0; round < 200; ++round)
+	{
+		std::map<std::wstring, int, string_utility::ordinal_ignore_case_less> reference;
+		ignore_case_hash_map<int> hashMap;
+		ignore_case_flat_map<int> flatMap;
+
+		for (int operation = 0; operation < 400; ++operation)
+		{
+			std::wstring key;
+			for (auto length = random() % 12; length > 0; --length)
+				key.push_back(c_alphabet[random() % 7]);
+
+			auto value = static_cast<int>(random() % 1000);
+			switch (random() % 4)
+			{
+			case 0:
+			case 1:
+				reference.insert_or_assign(key, value);
+				hashMap.insert_or_assign(key, value);
+				flatMap.insert_or_assign(key, value);
+				break;
+
+			case 2:
+			{
+				auto erased = reference.erase(key);
+				TAZ_CHECK(hashMap.erase(key) == erased);
+				TAZ_CHECK(flatMap.erase(key) == erased);
+				break;
+			}
+
+			default:
+			{
+				auto expected = reference.find(key);
+				auto hashed = hashMap.find(key);
+				auto flat = flatMap.find(key);
+				TAZ_CHECK((expected == reference.end()) == (hashed == hashMap.end()));
+				TAZ_CHECK((expected == reference.end()) == (flat == flatMap.end()));
+				if (expected != reference.end())
+					TAZ_CHECK(hashed->second == expected->second && flat->second == expected->second);
+				break;
+			}
+			}
+
+			TAZ_CHECK(hashMap.size() == reference.size() && flatMap.size() == reference.size());
+		}
+
+		// The flat map iterates in the same order as the reference.
+		auto expected = reference.begin();
+		for (auto const& [key, value] : flatMap)
+		{
+			TAZ_CHECK(string_utility::ordinal_ignore_case_equal_to{}(key, expected->first) && value == expected->second);
+			++expected;
+		}
+
+		for (auto const& [key, value] : hashMap)
+			TAZ_CHECK(reference.at(key) == value);
+
+		std::vector<std::pair<std::wstring, int>> entries(reference.begin(), reference.end());
+		entries.emplace_back(L"AAAA", 5);
+		ignore_case_flat_map<int> built{ entries };
+		TAZ_CHECK(built.size() == reference.size() + (reference.contains(L"aaaa") ? 0 : 1));
+	}
+
+	// Keys can't be changed through an iterator; the maps still copy and assign.
+	static_assert(std::is_same_v<ignore_case_hash_map<int>::value_type, std::pair<std::wstring const, int>>);
+	static_assert(std::is_same_v<ignore_case_flat_map<int>::value_type, std::pair<std::wstring const, int>>);
+	{
+		ignore_case_hash_map<int> hashMap;
+		ignore_case_flat_map<int> flatMap;
+		for (auto key : { L"b", L"a", L"C", L"d" })
+		{
+			hashMap.insert_or_assign(key, 1);
+			flatMap.insert_or_assign(key, 1);
+		}
+		hashMap.erase(L"B");
+		flatMap.erase(L"B");
+
+		ignore_case_hash_map<int> hashCopy;
+		ignore_case_flat_map<int> flatCopy;
+		hashCopy = hashMap;
+		flatCopy = flatMap;
+		TAZ_CHECK(hashCopy.size() == 3 && hashCopy.contains(L"c") && !hashCopy.contains(L"b"));
+		TAZ_CHECK(flatCopy.size() == 3 && flatCopy.begin()->first == L"a" && std::prev(flatCopy.end())->first == L"d");
+	}
+
+	// Non-ASCII units fold by the fixed simple mapping, whatever the locale: one to one only, and nothing outside
+	// the BMP.
+	TAZ_CHECK(string_utility::fold_case(L'\u00E9') == L'\u00C9');
+	TAZ_CHECK(string_utility::fold_case(L'\u0101') == L'\u0100' && string_utility::fold_case(L'\u0100') == L'\u0100');
+	TAZ_CHECK(string_utility::fold_case(L'\u00DF') == L'\u00DF');
+	TAZ_CHECK(string_utility::fold_case(L'\u1F80') == L'\u1F88');
+	TAZ_CHECK(string_utility::fold_case(L'\uFF41') == L'\uFF21');
+	TAZ_CHECK(string_utility::fold_case(L'\u4E00') == L'\u4E00');
+
+	ignore_case_hash_map<int> accented;
+	accented.insert_or_assign(L"caf\u00E9", 1);
+	TAZ_CHECK(accented.find(L"CAF\u00C9") != accented.end());
+
+	// The search folds as the maps do, including the two non-ASCII units that fold into ASCII, and past the
+	// vector-sized blocks.
+	std::wstring const haystack = std::wstring(40, L'\u65E5') + L"\u00E9T\u0131tle m\u0131\u017Fs\u00C9\u017Fs";
+	TAZ_CHECK(string_utility::find_ignore_case(haystack, L"\u00C9title") == 40);
+	TAZ_CHECK(string_utility::find_ignore_case(haystack, L"ISS") == 48);
+	TAZ_CHECK(string_utility::find_ignore_case(haystack, L"\u00E9ss") == 51);
+	TAZ_CHECK(string_utility::find_ignore_case(haystack, L"\u00E9sx") == std::wstring_view::npos);
+	TAZ_CHECK(string_utility::find_ignore_case(std::string_view{ "abc TIMEOUT" }, "Timeout") == 4);
+	return 0;
+}
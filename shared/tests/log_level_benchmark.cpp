@@ -0,0 +1,77 @@
+// Standard C++ headers
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+// tasler-cpp headers
+#include "taz/log_level.h"
+
+// Local headers
+#include "benchmark.h"
+
+namespace
+{
+	// Stands in for taz::logger, whose formatting needs <format> and WIL. An enabled line builds a string, as a
+	// real one would, so the disabled cases have something to be compared against.
+	template <taz::log_level MinLevel>
+	struct string_logger final
+	{
+		static constexpr bool is_enabled(taz::log_level level)
+		{
+			return taz::is_log_level_enabled(level, MinLevel);
+		}
+
+		void write_line(char const* format, std::size_t value)
+		{
+			m_line.assign(format).append(std::to_string(value));
+			m_written += m_line.size();
+		}
+
+		std::string m_line{};
+		std::size_t m_written{};
+	};
+
+	// The same check as log_category::is_enabled in logger.h: one relaxed load of a threshold another thread
+	// may change at any time.
+	struct atomic_category final
+	{
+		bool is_enabled(taz::log_level level) const
+		{
+			return level >= m_threshold.load(std::memory_order_relaxed);
+		}
+
+		std::atomic<taz::log_level> m_threshold{};
+	};
+}
+
+int main()
+{
+	constexpr std::size_t c_calls = 100'000'000;
+	string_logger<taz::log_level::info> logger;
+	atomic_category category{ taz::log_level::warning };
+
+	auto seconds = benchmark::best_seconds([&]
+	{
+		for (std::size_t call = 0; call < c_calls; ++call)
+			TAZ_LOG(logger, debug, "value ", call);
+	});
+	benchmark::report("TAZ_LOG below the compile-time minimum", seconds, c_calls, "call");
+
+	seconds = benchmark::best_seconds([&]
+	{
+		for (std::size_t call = 0; call < c_calls; ++call)
+			TAZ_LOG_CATEGORY(logger, category, info, "value ", call);
+	});
+	benchmark::report("TAZ_LOG_CATEGORY below the category threshold", seconds, c_calls, "call");
+
+	constexpr std::size_t c_enabledCalls = 10'000'000;
+	seconds = benchmark::best_seconds([&]
+	{
+		for (std::size_t call = 0; call < c_enabledCalls; ++call)
+			TAZ_LOG_CATEGORY(logger, category, error, "value ", call);
+	});
+	benchmark::report("TAZ_LOG_CATEGORY enabled, for comparison", seconds, c_enabledCalls, "call");
+
+	benchmark::keep(logger.m_written);
+	return 0;
+}
@@ -0,0 +1,68 @@
+// Standard C++ headers
+#include <string>
+
+// tasler-cpp headers
+#include "taz/log_level.h"
+
+// Local headers
+#include "check.h"
+
+namespace
+{
+	// Stands in for taz::logger, whose formatting needs <format> and WIL; TAZ_LOG only relies on these two.
+	template <taz::log_level MinLevel>
+	struct counting_logger final
+	{
+		static constexpr bool is_enabled(taz::log_level level)
+		{
+			return taz::is_log_level_enabled(level, MinLevel);
+		}
+
+		void write_line(std::string const&, int)
+		{
+			++m_written;
+		}
+
+		int m_written{};
+	};
+
+	struct fixed_category final
+	{
+		bool is_enabled(taz::log_level level) const
+		{
+			return level >= m_threshold;
+		}
+
+		taz::log_level m_threshold{};
+	};
+}
+
+int main()
+{
+	static_assert(!taz::is_log_level_enabled(taz::log_level::debug, taz::log_level::info));
+	static_assert(taz::is_log_level_enabled(taz::log_level::info, taz::log_level::info));
+	static_assert(!taz::is_log_level_enabled(taz::log_level::off, taz::log_level::trace));
+
+	counting_logger<taz::log_level::warning> logger;
+	int evaluated{};
+	auto expensive = [&] { return ++evaluated; };
+
+	// Below the compile-time minimum neither the call nor its arguments run.
+	TAZ_LOG(logger, trace, "{}", expensive());
+	TAZ_LOG(logger, info, std::string{ "{}" }, expensive());
+	TAZ_CHECK(evaluated == 0 && logger.m_written == 0);
+
+	TAZ_LOG(logger, error, "{}", expensive());
+	TAZ_CHECK(evaluated == 1 && logger.m_written == 1);
+
+	// A category only filters at run time, and likewise before the arguments are evaluated.
+	fixed_category category{ taz::log_level::critical };
+	TAZ_LOG_CATEGORY(logger, category, info, "{}", expensive());
+	TAZ_LOG_CATEGORY(logger, category, error, "{}", expensive());
+	TAZ_CHECK(evaluated == 1 && logger.m_written == 1);
+
+	category.m_threshold = taz::log_level::error;
+	TAZ_LOG_CATEGORY(logger, category, error, "{}", expensive());
+	TAZ_CHECK(evaluated == 2 && logger.m_written == 2);
+	return 0;
+}
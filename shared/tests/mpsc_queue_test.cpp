@@ -0,0 +1,69 @@
+// Standard C++ headers
+#include <cstdint>
+#include <memory>
+#include <ranges>
+#include <string>
+#include <thread>
+#include <vector>
+
+// tasler-cpp headers
+#include "taz/mpsc_queue.h"
+
+// Local headers
+#include "check.h"
+
+int main()
+{
+	constexpr int c_producers = 8;
+	constexpr int c_items = 100000;
+	taz::mpsc_queue<std::unique_ptr<int64_t>> queue;
+
+	std::vector<std::thread> producers;
+	for (int producer = 0; producer < c_producers; ++producer)
+	{
+		producers.emplace_back([&queue, producer]
+		{
+			for (int item = 0; item < c_items; ++item)
+				queue.push(std::make_unique<int64_t>(int64_t{ producer } << 32 | item));
+		});
+	}
+
+	// Each producer's items arrive in the order it pushed them.
+	std::vector<int64_t> last(c_producers, -1);
+	for (int64_t count = 0; count < int64_t{ c_producers } * c_items; )
+	{
+		if (auto item = queue.try_pop())
+		{
+			auto producer = static_cast<int>(**item >> 32);
+			auto index = **item & 0xFFFFFFFF;
+			TAZ_CHECK(index == last[producer] + 1);
+			last[producer] = index;
+			++count;
+		}
+	}
+
+	for (auto& producer : producers)
+		producer.join();
+	TAZ_CHECK(!queue.try_pop());
+
+	std::vector<std::unique_ptr<int64_t>> batch;
+	for (int item = 0; item < 10; ++item)
+		batch.push_back(std::make_unique<int64_t>(item));
+	TAZ_CHECK(queue.push_range(std::move(batch)) == 10);
+	for (int item = 0; item < 10; ++item)
+		TAZ_CHECK(**queue.try_pop() == item);
+
+	// An lvalue range is copied from, an rvalue one moved from.
+	taz::mpsc_queue<std::string> strings;
+	std::vector<std::string> names{ "first name long enough to allocate", "second name long enough to allocate" };
+	TAZ_CHECK(strings.push_range(names) == 2);
+	TAZ_CHECK(names[0] == "first name long enough to allocate" && names[1] == "second name long enough to allocate");
+	TAZ_CHECK(strings.push_range(names | std::views::take(1)) == 1);
+	TAZ_CHECK(names[0] == "first name long enough to allocate");
+	TAZ_CHECK(strings.push_range(std::move(names)) == 2);
+	TAZ_CHECK(names[0].empty() && names[1].empty());
+	for (auto expected : { "first", "second", "first", "first", "second" })
+		TAZ_CHECK(strings.try_pop()->starts_with(expected));
+	TAZ_CHECK(!strings.try_pop());
+	return 0;
+}
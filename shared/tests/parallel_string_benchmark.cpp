@@ -0,0 +1,68 @@
+// Standard C headers
+#include <stdio.h>
+#include <stdlib.h>
+
+// Standard C++ headers
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <thread>
+
+// tasler-cpp headers
+#include "taz/parallel_string.h"
+
+// Local headers
+#include "benchmark.h"
+
+using namespace taz::string_utility;
+
+namespace
+{
+	// A template-like document: markup with a placeholder every few lines and the odd accented word.
+	std::string make_document(std::size_t bytes)
+	{
+		std::string text;
+		for (std::size_t line = 0; text.size() < bytes; ++line)
+		{
+			text += "<tr><td>row " + std::to_string(line) + "</td><td>{{name}} caf\xC3\xA9</td><td>";
+			text += (line % 3 == 0) ? "{{value}}" : "constant";
+			text += "</td></tr>\n";
+		}
+		return text;
+	}
+}
+
+// Usage: parallel_string_benchmark [max workers]; the default is the number of hardware threads.
+int main(int argc, char** argv)
+{
+	auto hardware = std::max(1u, std::thread::hardware_concurrency());
+	std::size_t maxWorkers = argc > 1 ? static_cast<std::size_t>(atoi(argv[1])) : hardware;
+	printf("hardware threads: %u\n", hardware);
+
+	auto const document = make_document(32 * 1024 * 1024);
+	auto const wideDocument = widen(document);
+	replacer const templates{ { { "{{name}}", "Ada Lovelace" }, { "{{value}}", "42" }, { "<td>", "<td class=\"c\">" } } };
+
+	auto serialReplace = benchmark::best_seconds([&] { benchmark::keep(templates.replace_all(document).size()); }, 3);
+	auto serialWiden = benchmark::best_seconds([&] { benchmark::keep(widen(document).size()); }, 3);
+	auto serialNarrow = benchmark::best_seconds([&] { benchmark::keep(narrow(wideDocument).size()); }, 3);
+	printf("%zu MB; serial: replace_all %.1f ms, widen %.1f ms, narrow %.1f ms\n", document.size() >> 20,
+		serialReplace * 1e3, serialWiden * 1e3, serialNarrow * 1e3);
+
+	for (std::size_t workers = 1; workers <= maxWorkers; workers *= 2)
+	{
+		string_pool pool{ workers };
+		if (parallel_replace_all(templates, document, pool) != templates.replace_all(document) || parallel_widen(document, pool) != wideDocument)
+		{
+			fprintf(stderr, "parallel results differ from the serial ones\n");
+			return 1;
+		}
+
+		auto replace = benchmark::best_seconds([&] { benchmark::keep(parallel_replace_all(templates, document, pool).size()); }, 3);
+		auto wide = benchmark::best_seconds([&] { benchmark::keep(parallel_widen(document, pool).size()); }, 3);
+		auto narrowed = benchmark::best_seconds([&] { benchmark::keep(parallel_narrow(wideDocument, pool).size()); }, 3);
+		printf("  %3zu workers: replace_all %7.1f ms (%.2fx), widen %7.1f ms (%.2fx), narrow %7.1f ms (%.2fx)\n", workers,
+			replace * 1e3, serialReplace / replace, wide * 1e3, serialWiden / wide, narrowed * 1e3, serialNarrow / narrowed);
+	}
+	return 0;
+}
@@ -0,0 +1,75 @@
+// Standard C++ headers
+#include <atomic>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// tasler-cpp headers
+#include "taz/parallel_string.h"
+
+// Local headers
+#include "check.h"
+
+using namespace taz::string_utility;
+
+int main()
+{
+	string_pool pool{ 4 };
+	std::mt19937 random{ 7 };
+	std::vector<std::string> const patterns{ "ab", "a", "aaaa", "ba", "bbbbbbbbbbbbbbbbbbbbbb", "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa" };
+
+	// Large enough inputs to be split into several chunks; results must match the serial versions exactly.
+	for (int iteration = 0; iteration < 40; ++iteration)
+	{
+		std::size_t length = 64 * 1024 * (1 + random() % 6) + random() % 1000;
+		std::string text(length, 'a');
+		for (auto& character : text)
+		{
+			auto kind = random() % 10;
+			character = kind < 6 ? static_cast<char>('a' + random() % 2) : kind < 8 ? '\xC3' : static_cast<char>(0x80 + random() % 64);
+		}
+
+		std::vector<std::pair<std::string_view, std::string_view>> replacements;
+		for (auto const& pattern : patterns)
+		{
+			if (random() % 2)
+				replacements.emplace_back(pattern, patterns[random() % patterns.size()]);
+		}
+		if (iteration % 3 == 0)
+		{
+			text.assign(length, 'a');
+			replacements = { { "aaa", "X" }, { "aa", "Y" } };
+		}
+
+		replacer compiled{ replacements };
+		TAZ_CHECK(parallel_replace_all(compiled, text, pool) == compiled.replace_all(text));
+
+		auto wide = widen(text);
+		TAZ_CHECK(parallel_widen(text, pool) == wide);
+		TAZ_CHECK(parallel_narrow(wide, pool) == narrow(wide));
+	}
+
+	// Called from pool workers, including from every worker at once, the caller finishes the work itself
+	// rather than waiting on helpers that no free worker is left to run.
+	std::string const text(4 * c_parallelMinimumChunk, 'a');
+	auto const wide = widen(text);
+	for (std::size_t workers : { 1, 2 })
+	{
+		string_pool nested{ workers };
+		std::atomic<int> matched{};
+		for (std::size_t task = 0; task < workers; ++task)
+		{
+			nested.push(taz::inplace_task<>{ [&]
+			{
+				if (parallel_widen(text, nested) == wide)
+					++matched;
+			} });
+		}
+		nested.wait_idle();
+		TAZ_CHECK(matched == static_cast<int>(workers));
+	}
+	return 0;
+}
@@ -0,0 +1,135 @@
+// Standard C headers
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Standard C++ headers
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+// tasler-cpp headers
+#include "taz/spill_writer.h"
+
+// Local headers
+#include "check.h"
+
+namespace
+{
+	std::string make_lines(std::size_t size)
+	{
+		std::string lines;
+		for (int line = 0; lines.size() < size; ++line)
+			lines += "line " + std::to_string(line) + "\n";
+		return lines;
+	}
+
+	void write_all(taz::spill_writer& writer, std::string_view text)
+	{
+		for (std::size_t offset = 0; offset < text.size(); offset += 1000)
+			writer.write(text.substr(offset, 1000));
+	}
+
+	std::string read_all(int descriptor)
+	{
+		std::string received;
+		char buffer[4096];
+		for (ssize_t read{}; (read = ::read(descriptor, buffer, sizeof(buffer))) > 0; )
+			received.append(buffer, static_cast<std::size_t>(read));
+		return received;
+	}
+}
+
+int main()
+{
+	using namespace std::chrono_literals;
+
+	// Streams that can't stall get no writer.
+	auto file = tmpfile();
+	TAZ_CHECK(!taz::spill_writer::create(file));
+	fclose(file);
+
+	auto expected = make_lines(1024 * 1024);
+
+	// Far more than the pipe holds, written with nobody reading: the excess is spilled, nothing blocks, and the
+	// descriptor is left in blocking mode. finish() gives up on the stalled reader and leaves exactly what it
+	// never received in the spill file.
+	{
+		int descriptors[2]{};
+		TAZ_CHECK(pipe(descriptors) == 0);
+		auto output = fdopen(descriptors[1], "wb");
+
+		auto writer = taz::spill_writer::create(output);
+		TAZ_CHECK(writer);
+		write_all(*writer, expected);
+		TAZ_CHECK(writer->pending() && !writer->drain());
+		TAZ_CHECK(!(fcntl(descriptors[1], F_GETFL) & O_NONBLOCK));
+		TAZ_CHECK(std::filesystem::exists(writer->spill_path()));
+
+		TAZ_CHECK(!writer->finish(20ms));
+		auto path = writer->spill_path();
+		writer.reset();
+		fclose(output);
+
+		auto received = read_all(descriptors[0]);
+		close(descriptors[0]);
+		std::ifstream unsent{ path, std::ios::binary };
+		received.append(std::istreambuf_iterator<char>{ unsent }, std::istreambuf_iterator<char>{});
+		unsent.close();
+		TAZ_CHECK(received == expected);
+		std::filesystem::remove(path);
+	}
+
+	// With a reader, finish() sends the rest in order and removes the spill file.
+	{
+		int descriptors[2]{};
+		TAZ_CHECK(pipe(descriptors) == 0);
+		auto output = fdopen(descriptors[1], "wb");
+
+		auto writer = taz::spill_writer::create(output);
+		write_all(*writer, expected);
+		auto path = writer->spill_path();
+
+		std::string received;
+		std::thread reader([&] { received = read_all(descriptors[0]); });
+		TAZ_CHECK(writer->finish(60s));
+		writer.reset();
+		fclose(output);
+		reader.join();
+		close(descriptors[0]);
+
+		TAZ_CHECK(received == expected);
+		TAZ_CHECK(!std::filesystem::exists(path));
+	}
+
+	// Without anywhere to spill, writes wait for the reader rather than dropping text. The reader starts late so
+	// that the pipe is sure to fill.
+	{
+		int descriptors[2]{};
+		TAZ_CHECK(pipe(descriptors) == 0);
+		auto output = fdopen(descriptors[1], "wb");
+		TAZ_CHECK(setenv("TMPDIR", "/nonexistent/taz-spill-test", 1) == 0);
+
+		std::string received;
+		std::thread reader([&]
+		{
+			std::this_thread::sleep_for(50ms);
+			received = read_all(descriptors[0]);
+		});
+		auto writer = taz::spill_writer::create(output);
+		write_all(*writer, expected);
+		TAZ_CHECK(writer->failed() && !writer->pending());
+		TAZ_CHECK(writer->finish(0ms));
+		writer.reset();
+		fclose(output);
+		reader.join();
+		close(descriptors[0]);
+
+		TAZ_CHECK(received == expected);
+	}
+	return 0;
+}
@@ -0,0 +1,84 @@
+// Standard C++ headers
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// tasler-cpp headers
+#include "taz/string_replacer.h"
+
+// Local headers
+#include "check.h"
+
+using namespace taz::string_utility;
+
+namespace
+{
+	using replacement_list = std::vector<std::pair<std::string_view, std::string_view>>;
+
+	// Leftmost, then longest, then first listed; replaced text is never rescanned.
+	std::string reference_replace(std::string_view text, replacement_list const& replacements)
+	{
+		std::string result;
+		for (std::size_t position = 0; position < text.size(); )
+		{
+			std::size_t bestLength{};
+			std::string_view const* best{};
+			for (auto const& [from, to] : replacements)
+			{
+				if (!from.empty() && from.size() > bestLength && text.substr(position, from.size()) == from)
+				{
+					bestLength = from.size();
+					best = &to;
+				}
+			}
+
+			if (best)
+			{
+				result.append(*best);
+				position += bestLength;
+			}
+			else
+			{
+				result.push_back(text[position++]);
+			}
+		}
+		return result;
+	}
+}
+
+int main()
+{
+	std::mt19937 random{ 5 };
+	for (int iteration = 0; iteration < 20000; ++iteration)
+	{
+		std::vector<std::string> storage;
+		for (auto count = random() % 6; count > 0; --count)
+		{
+			std::string pattern;
+			for (auto length = random() % 5; length > 0; --length)
+				pattern.push_back(static_cast<char>('a' + random() % 3));
+			storage.push_back(pattern);
+			storage.push_back(std::string(random() % 3, static_cast<char>('X' + count)));
+		}
+
+		replacement_list replacements;
+		for (std::size_t index = 0; index < storage.size(); index += 2)
+			replacements.emplace_back(storage[index], storage[index + 1]);
+
+		std::string text;
+		for (auto length = random() % 60; length > 0; --length)
+			text.push_back(static_cast<char>('a' + random() % 3));
+
+		replacer compiled{ replacements };
+		TAZ_CHECK(compiled.replace_all(text) == reference_replace(text, replacements));
+	}
+
+	wreplacer wide{ { { L"he", L"HE" }, { L"hers", L"X" } } };
+	TAZ_CHECK(wide.replace_all(L"ushers he") == L"usX HE");
+
+	replacer duplicates{ { { "a", "1" }, { "a", "2" }, { "", "empty" } } };
+	TAZ_CHECK(duplicates.replace_all("banana") == "b1n1n1");
+	return 0;
+}
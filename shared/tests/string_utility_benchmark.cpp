@@ -0,0 +1,115 @@
+// Standard C headers
+#include <stdio.h>
+
+// Standard C++ headers
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cwctype>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// tasler-cpp headers
+#include "taz/string_utility.h"
+
+// Local headers
+#include "benchmark.h"
+
+using namespace taz::string_utility;
+
+namespace
+{
+	constexpr std::size_t c_textSize = 8 * 1024 * 1024;
+
+	template <typename CharT>
+	std::basic_string<CharT> repeat(std::basic_string_view<CharT> unit, std::size_t units)
+	{
+		std::basic_string<CharT> text;
+		while (text.size() < units)
+			text.append(unit);
+		return text;
+	}
+
+	// What the search replaced: upper-case a copy of the whole buffer, then find in it.
+	template <typename CharT>
+	std::size_t count_transform_then_find(std::basic_string_view<CharT> text, std::basic_string_view<CharT> pattern)
+	{
+		std::basic_string<CharT> upperText(text);
+		std::basic_string<CharT> upperPattern(pattern);
+		auto upper = [](CharT character)
+		{
+			if constexpr (sizeof(CharT) == 1)
+				return static_cast<CharT>(std::toupper(static_cast<unsigned char>(character)));
+			else
+				return static_cast<CharT>(std::towupper(static_cast<wint_t>(character)));
+		};
+		std::transform(upperText.begin(), upperText.end(), upperText.begin(), upper);
+		std::transform(upperPattern.begin(), upperPattern.end(), upperPattern.begin(), upper);
+
+		std::size_t count{};
+		for (auto found = upperText.find(upperPattern); found != std::basic_string<CharT>::npos; found = upperText.find(upperPattern, found + 1))
+			++count;
+		return count;
+	}
+
+	template <typename CharT>
+	std::size_t count_find_ignore_case(std::basic_string_view<CharT> text, std::basic_string_view<CharT> pattern)
+	{
+		std::size_t count{};
+		for (auto found = find_ignore_case(text, pattern); found != std::basic_string_view<CharT>::npos; found = find_ignore_case(text, pattern, found + 1))
+			++count;
+		return count;
+	}
+
+	template <typename CharT>
+	void compare_search(char const* name, std::basic_string_view<CharT> unit, std::basic_string_view<CharT> pattern)
+	{
+		auto text = repeat(unit, c_textSize / sizeof(CharT));
+		std::basic_string_view<CharT> view{ text };
+		if (count_transform_then_find(view, pattern) != count_find_ignore_case(view, pattern))
+			printf("  (match counts differ: towupper and fold_case disagree on some unit)\n");
+
+		printf("\n%s, %zu MB\n", name, text.size() * sizeof(CharT) >> 20);
+		auto bytes = text.size() * sizeof(CharT);
+		benchmark::report_throughput("  transform, then find", benchmark::best_seconds([&] { benchmark::keep(count_transform_then_find(view, pattern)); }), bytes);
+		benchmark::report_throughput("  find_ignore_case", benchmark::best_seconds([&] { benchmark::keep(count_find_ignore_case(view, pattern)); }), bytes);
+	}
+}
+
+int main()
+{
+	compare_search<char>("narrow log text, no match", "2024-05-01 12:00:00 [info] request id=42 completed in 12 ms\n", "TIMEOUT");
+	compare_search<char>("narrow log text, frequent match", "2024-05-01 12:00:00 [info] request id=42 completed in 12 ms\n", "Request");
+	compare_search<wchar_t>("wide ASCII text, no match", L"HKEY_LOCAL_MACHINE\\Software\\Contoso\\Settings value=1\n", L"timeout");
+	compare_search<wchar_t>("wide CJK text, no match", L"日本語のテキスト 設定\n", L"timeout");
+
+	// Counting fields: a lazy split over views against splitting into a vector of copies with getline.
+	auto csv = repeat<char>("alpha,beta,gamma,delta,epsilon,zeta,eta,theta\n", c_textSize);
+	std::string_view csvView{ csv };
+	printf("\nsplitting %zu MB on ','\n", csv.size() >> 20);
+	benchmark::report_throughput("  getline into a vector<string>", benchmark::best_seconds([&]
+	{
+		std::vector<std::string> fields;
+		std::istringstream stream{ csv };
+		for (std::string field; std::getline(stream, field, ','); )
+			fields.push_back(std::move(field));
+		benchmark::keep(fields.size());
+	}), csv.size());
+	benchmark::report_throughput("  split", benchmark::best_seconds([&]
+	{
+		std::size_t fields{};
+		for (auto field : split(csvView, ","))
+			fields += !field.empty();
+		benchmark::keep(fields);
+	}), csv.size());
+	benchmark::report_throughput("  tokenize on \",\\n\"", benchmark::best_seconds([&]
+	{
+		std::size_t tokens{};
+		for (auto token : tokenize(csvView, ",\n"))
+			tokens += token.size();
+		benchmark::keep(tokens);
+	}), csv.size());
+	return 0;
+}
@@ -0,0 +1,90 @@
+// Standard C headers
+#include <stdio.h>
+#include <stdlib.h>
+
+// Standard C++ headers
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+// tasler-cpp headers
+#include "taz/thread_pool.h"
+
+// Local headers
+#include "benchmark.h"
+
+namespace
+{
+	std::atomic<uint64_t> g_checksum{};
+
+	// Spins for roughly `rounds` multiply-xorshift steps, so the cost of an item can be dialled from a few
+	// nanoseconds, which measures the pool's own overhead, up to tens of microseconds.
+	struct compute_item final
+	{
+		void execute()
+		{
+			auto state = m_seed;
+			for (uint32_t round = 0; round < m_rounds; ++round)
+			{
+				state ^= state >> 31;
+				state *= 0x9E3779B97F4A7C15ull;
+			}
+			g_checksum.fetch_add(state, std::memory_order_relaxed);
+		}
+
+		uint64_t m_seed{};
+		uint32_t m_rounds{};
+	};
+
+	double run(std::size_t workers, std::size_t items, uint32_t rounds)
+	{
+		return benchmark::best_seconds([&]
+		{
+			taz::thread_pool<compute_item> pool{ workers };
+			for (std::size_t item = 0; item < items; ++item)
+				pool.push(compute_item{ item, rounds });
+			pool.wait_idle();
+		}, 3);
+	}
+}
+
+// Usage: thread_pool_benchmark [max workers]; the default is the number of hardware threads.
+int main(int argc, char** argv)
+{
+	auto hardware = std::max(1u, std::thread::hardware_concurrency());
+	std::size_t maxWorkers = argc > 1 ? static_cast<std::size_t>(atoi(argv[1])) : hardware;
+	printf("hardware threads: %u\n", hardware);
+
+	struct workload final
+	{
+		char const* m_name;
+		std::size_t m_items;
+		uint32_t m_rounds;
+	};
+	constexpr workload c_workloads[] = {
+		{ "tiny items (pool overhead)", 2'000'000, 1 },
+		{ "~1 us items", 200'000, 400 },
+		{ "~20 us items", 10'000, 8'000 },
+	};
+
+	for (auto const& [name, items, rounds] : c_workloads)
+	{
+		auto serial = benchmark::best_seconds([&]
+		{
+			for (std::size_t item = 0; item < items; ++item)
+				compute_item{ item, rounds }.execute();
+		}, 3);
+		printf("\n%s: %zu items, serial %.1f ms\n", name, items, serial * 1e3);
+
+		for (std::size_t workers = 1; workers <= maxWorkers; workers *= 2)
+		{
+			auto seconds = run(workers, items, rounds);
+			printf("  %3zu workers %10.1f ms %8.2fx serial\n", workers, seconds * 1e3, serial / seconds);
+		}
+	}
+
+	benchmark::keep(static_cast<std::size_t>(g_checksum.load()));
+	return 0;
+}
@@ -0,0 +1,110 @@
+// Standard C++ headers
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+// tasler-cpp headers
+#include "taz/thread_pool.h"
+
+// Local headers
+#include "check.h"
+
+namespace
+{
+	// Each item with depth left pushes two more from inside the pool, so most pushes land on a worker's own deque
+	// and the rest of the pool has to steal.
+	struct spawning_item final
+	{
+		void execute()
+		{
+			m_count->fetch_add(1, std::memory_order_relaxed);
+			if (m_depth == 0)
+				return;
+
+			for (int child = 0; child < 2; ++child)
+				(*m_push)(spawning_item{ m_depth - 1, m_count, m_push });
+		}
+
+		int m_depth{};
+		std::atomic<std::size_t>* m_count{};
+		std::function<bool(spawning_item&&)>* m_push{};
+	};
+
+	struct throwing_item final
+	{
+		void execute()
+		{
+			throw std::runtime_error{ "thrown" };
+		}
+	};
+}
+
+int main()
+{
+	{
+		taz::thread_pool<spawning_item> pool{ 4 };
+		std::atomic<std::size_t> count{};
+		std::function<bool(spawning_item&&)> push = [&](spawning_item&& item) { return pool.push(std::move(item)); };
+
+		for (int round = 0; round < 20; ++round)
+		{
+			count = 0;
+			TAZ_CHECK(pool.push(spawning_item{ 12, &count, &push }));
+			pool.wait_idle();
+			TAZ_CHECK(count == (std::size_t{ 1 } << 13) - 1);
+		}
+
+		// Items pushed by running items during exit() still run; pushes from outside after it are refused, and
+		// wait_idle() does not wait for them.
+		count = 0;
+		TAZ_CHECK(pool.push(spawning_item{ 10, &count, &push }));
+		pool.exit();
+		TAZ_CHECK(count == (std::size_t{ 1 } << 11) - 1);
+		TAZ_CHECK(!pool.push(spawning_item{ 0, &count, &push }));
+		pool.wait_idle();
+		TAZ_CHECK(count == (std::size_t{ 1 } << 11) - 1);
+	}
+
+	// Producers racing exit() either have their item run or are told it wasn't queued.
+	for (int round = 0; round < 50; ++round)
+	{
+		taz::thread_pool<spawning_item> pool{ 2 };
+		std::atomic<std::size_t> count{};
+		std::atomic<std::size_t> accepted{};
+		std::function<bool(spawning_item&&)> push = [&](spawning_item&& item) { return pool.push(std::move(item)); };
+
+		std::thread producer([&]
+		{
+			for (int item = 0; item < 1000; ++item)
+			{
+				if (pool.push(spawning_item{ 0, &count, &push }))
+					accepted.fetch_add(1);
+			}
+		});
+		pool.exit();
+		producer.join();
+		pool.wait_idle();
+		TAZ_CHECK(count == accepted);
+	}
+
+	// The first exception escaping an item is rethrown by wait_idle(), once.
+	{
+		taz::thread_pool<throwing_item> pool{ 2 };
+		pool.push(throwing_item{});
+		pool.push(throwing_item{});
+		auto thrown = false;
+		try
+		{
+			pool.wait_idle();
+		}
+		catch (std::runtime_error const&)
+		{
+			thrown = true;
+		}
+		TAZ_CHECK(thrown);
+		pool.wait_idle();
+	}
+	return 0;
+}
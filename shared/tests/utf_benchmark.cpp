@@ -0,0 +1,104 @@
+// Standard C headers
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <wchar.h>
+
+// Standard C++ headers
+#include <cstddef>
+#include <string>
+
+// tasler-cpp headers
+#include "taz/string_utility.h"
+
+// Local headers
+#include "benchmark.h"
+
+namespace
+{
+	// The shape of the code narrow and widen replaced: ask the platform for the output length, allocate, then
+	// convert again. On Windows that was MultiByteToWideChar/WideCharToMultiByte; the portable equivalents are
+	// the restartable conversions in a UTF-8 locale.
+	std::wstring two_pass_widen(std::string const& text)
+	{
+		mbstate_t state{};
+		char const* source = text.c_str();
+		auto length = mbsrtowcs(nullptr, &source, 0, &state);
+		std::wstring result(length, L'\0');
+		source = text.c_str();
+		state = {};
+		mbsrtowcs(result.data(), &source, length, &state);
+		return result;
+	}
+
+	std::string two_pass_narrow(std::wstring const& text)
+	{
+		mbstate_t state{};
+		wchar_t const* source = text.c_str();
+		auto length = wcsrtombs(nullptr, &source, 0, &state);
+		std::string result(length, '\0');
+		source = text.c_str();
+		state = {};
+		wcsrtombs(result.data(), &source, length, &state);
+		return result;
+	}
+
+	std::string repeat(std::string_view unit, std::size_t bytes)
+	{
+		std::string text;
+		while (text.size() < bytes)
+			text.append(unit);
+		return text;
+	}
+
+	void compare(char const* name, std::string const& utf8)
+	{
+		constexpr int c_rounds = 20;
+		auto wide = taz::string_utility::widen(utf8);
+		if (wide != two_pass_widen(utf8) || taz::string_utility::narrow(wide) != two_pass_narrow(wide))
+		{
+			fprintf(stderr, "%s: results differ\n", name);
+			exit(1);
+		}
+
+		printf("\n%s, %zu bytes of UTF-8\n", name, utf8.size());
+		auto bytes = utf8.size() * c_rounds;
+		benchmark::report_throughput("  widen, two-pass mbsrtowcs", benchmark::best_seconds([&]
+		{
+			for (int round = 0; round < c_rounds; ++round)
+				benchmark::keep(two_pass_widen(utf8).size());
+		}), bytes);
+		benchmark::report_throughput("  widen, string_utility", benchmark::best_seconds([&]
+		{
+			for (int round = 0; round < c_rounds; ++round)
+				benchmark::keep(taz::string_utility::widen(utf8).size());
+		}), bytes);
+		benchmark::report_throughput("  narrow, two-pass wcsrtombs", benchmark::best_seconds([&]
+		{
+			for (int round = 0; round < c_rounds; ++round)
+				benchmark::keep(two_pass_narrow(wide).size());
+		}), bytes);
+		benchmark::report_throughput("  narrow, string_utility", benchmark::best_seconds([&]
+		{
+			for (int round = 0; round < c_rounds; ++round)
+				benchmark::keep(taz::string_utility::narrow(wide).size());
+		}), bytes);
+	}
+}
+
+// Throughput is in bytes of UTF-8 either way.
+int main()
+{
+	if (!setlocale(LC_ALL, "C.UTF-8"))
+	{
+		fprintf(stderr, "the C.UTF-8 locale is needed for the two-pass baseline\n");
+		return 1;
+	}
+
+	constexpr std::size_t c_size = 1024 * 1024;
+	compare("log lines (ASCII)", repeat("2024-05-01 12:00:00.123 [info] request completed in 12 ms\n", c_size));
+	compare("mostly ASCII, some accents", repeat("Caf\xC3\xA9 cr\xC3\xA8me br\xC3\xBBl\xC3\xA9" "e, na\xC3\xAFve fa\xC3\xA7" "ade; ", c_size));
+	compare("CJK", repeat("\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\xE3\x81\xAE\xE3\x83\x86\xE3\x82\xAD\xE3\x82\xB9\xE3\x83\x88", c_size));
+	compare("emoji (outside the BMP)", repeat("\xF0\x9F\x98\x80\xF0\x9F\x9A\x80 ok ", c_size));
+	return 0;
+}
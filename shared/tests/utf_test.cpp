@@ -0,0 +1,104 @@
+// Standard C++ headers
+#include <random>
+#include <string>
+#include <string_view>
+
+// tasler-cpp headers
+#include "taz/utf.h"
+
+// Local headers
+#include "check.h"
+
+using namespace taz::utf;
+
+namespace
+{
+	template <wide_character W>
+	std::basic_string<W> to_wide(std::string_view text)
+	{
+		std::basic_string<W> result(max_wide_length(text.size()), W{});
+		auto converted = utf8_to_wide<W>(text, result);
+		TAZ_CHECK(converted.ok() && converted.m_read == text.size());
+		result.resize(converted.m_written);
+		TAZ_CHECK(wide_length<W>(text) == result.size());
+		return result;
+	}
+
+	template <wide_character W>
+	std::string to_utf8(std::basic_string_view<W> text)
+	{
+		std::string result(max_utf8_length<W>(text.size()), '\0');
+		auto converted = wide_to_utf8<W>(text, result);
+		TAZ_CHECK(converted.ok() && converted.m_read == text.size());
+		result.resize(converted.m_written);
+		TAZ_CHECK(utf8_length<W>(text) == result.size());
+		return result;
+	}
+}
+
+int main()
+{
+	// Ill-formed sequences become one U+FFFD per maximal subpart (Unicode table 3-8).
+	TAZ_CHECK(to_wide<char16_t>("\x61\xF1\x80\x80\xE1\x80\xC2\x62\x80\x63\x80\xBF\x64") == u"a���b�c��d");
+	TAZ_CHECK(to_wide<char16_t>("\xED\xA0\x80") == u"���");
+	TAZ_CHECK(to_wide<char16_t>("\xF0\x9F\x98\x80") == u"\U0001F600");
+	TAZ_CHECK(to_wide<char32_t>("\xF0\x9F\x98\x80") == U"\U0001F600");
+	TAZ_CHECK(to_utf8<char16_t>(u"\U0001F600x") == "\xF0\x9F\x98\x80x");
+
+	std::u16string loneSurrogates{ u"a" };
+	loneSurrogates += char16_t{ 0xD800 };
+	loneSurrogates += u"b";
+	loneSurrogates += char16_t{ 0xDC00 };
+	TAZ_CHECK(to_utf8<char16_t>(loneSurrogates) == "a\xEF\xBF\xBD" "b\xEF\xBF\xBD");
+
+	// Streaming: an incomplete tail is left unread when more input may follow.
+	{
+		std::u16string output(10, u'\0');
+		auto result = utf8_to_wide<char16_t>("ab\xF0\x9F", output, false);
+		TAZ_CHECK(result.m_status == conversion_status::incomplete_input && result.m_read == 2 && result.m_written == 2);
+	}
+	{
+		std::string output(10, '\0');
+		std::u16string input{ u"a" };
+		input += char16_t{ 0xD83D };
+		auto result = wide_to_utf8<char16_t>(input, output, false);
+		TAZ_CHECK(result.m_status == conversion_status::incomplete_input && result.m_read == 1);
+	}
+	{
+		std::u16string output(3, u'\0');
+		auto result = utf8_to_wide<char16_t>("abcdef", output);
+		TAZ_CHECK(result.m_status == conversion_status::output_too_small && result.m_read == 3 && result.m_written == 3);
+	}
+
+	// Random round trips with long ASCII runs, which take the vectorized paths, and random garbage.
+	std::mt19937 random{ 1 };
+	for (int iteration = 0; iteration < 20000; ++iteration)
+	{
+		std::u32string codePoints;
+		auto count = random() % 200;
+		for (std::size_t index = 0; index < count; ++index)
+		{
+			auto kind = random() % 10;
+			char32_t codePoint = kind < 7 ? random() % 0x80 : kind < 8 ? 0x80 + random() % 0x780 : kind < 9 ? 0x800 + random() % 0xF800 : 0x10000 + random() % 0x100000;
+			codePoints.push_back(codePoint >= 0xD800 && codePoint <= 0xDFFF ? U'x' : codePoint);
+		}
+
+		auto utf8 = to_utf8<char32_t>(codePoints);
+		TAZ_CHECK(is_valid_utf8(utf8));
+		TAZ_CHECK(to_wide<char32_t>(utf8) == codePoints);
+		TAZ_CHECK(to_utf8<char16_t>(to_wide<char16_t>(utf8)) == utf8);
+		TAZ_CHECK(to_utf8<wchar_t>(to_wide<wchar_t>(utf8)) == utf8);
+
+		std::string garbage;
+		for (std::size_t index = 0; index < count; ++index)
+			garbage.push_back(static_cast<char>(random() % (iteration % 2 ? 256 : 130)));
+		to_wide<char16_t>(garbage);
+		to_wide<char32_t>(garbage);
+
+		std::u16string garbage16;
+		for (std::size_t index = 0; index < count; ++index)
+			garbage16.push_back(static_cast<char16_t>(random() % 3 ? random() % 0x80 : 0xD700 + random() % 0x400));
+		to_utf8<char16_t>(garbage16);
+	}
+	return 0;
+}